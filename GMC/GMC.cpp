@@ -6,9 +6,17 @@ See the README file in the top-level RNMC directory.
 ---------------------------------------------------------------------- */
 
 #include <getopt.h>
+#include <sstream>
+#include <limits>
+#include <climits>
+#include <cmath>
 
 #include "sql_types.h"
 #include "linear_solver.h"
+#include "tree_solver.h"
+#include "kary_tree_solver.h"
+#include "sparse_solver.h"
+#include "composition_rejection_solver.h"
 #include "../core/dispatcher.h"
 #include "../core/reaction_network_simulation.h"
 #include "../core/energy_reaction_network_simulation.h"
@@ -23,15 +31,110 @@ void print_usage()
               << "--thread_count\n"
               << "--step_cutoff|time_cutoff\n"
               << "--energy_budget\n"
-              << "--checkpoint\n";
+              << "--checkpoint\n"
+              << "--solver (optional: linear|tree|kary_tree|sparse|composition_rejection)\n"
+              << "--synchronous (optional: normal|off, sqlite sync mode during the run)\n"
+              << "--trajectory_file (optional: write trajectories to this binary file instead of the database)\n"
+              << "--sample_interval (optional: write species counts at multiples of this time instead of trajectories)\n"
+              << "--sample_species (optional: comma separated numeric species ids of the sampled species, default all)\n";
 } // print_usage()
 
 /* ---------------------------------------------------------------------- */
 
+template <typename Solver>
+void run_reaction_network(char *reaction_database,
+                          char *initial_state_database,
+                          int number_of_simulations,
+                          int base_seed,
+                          int thread_count,
+                          Cutoff cutoff,
+                          ReactionNetworkParameters parameters,
+                          SqlWriteProfile write_profile,
+                          std::string trajectory_file,
+                          Sampling sampling)
+{
+    Dispatcher<
+        Solver,
+        GillespieReactionNetwork,
+        ReactionNetworkParameters,
+        ReactionNetworkWriteTrajectoriesSql,
+        ReactionNetworkReadTrajectoriesSql,
+        ReactionNetworkWriteStateSql,
+        ReactionNetworkReadStateSql,
+        WriteCutoffSql,
+        ReadCutoffSql,
+        ReactionNetworkStateHistoryElement,
+        ReactionNetworkTrajectoryHistoryElement,
+        CutoffHistoryElement,
+        ReactionNetworkSimulation<Solver>,
+        std::vector<int>>
+
+        dispatcher(
+            reaction_database,
+            initial_state_database,
+            number_of_simulations,
+            base_seed,
+            thread_count,
+            cutoff,
+            parameters,
+            write_profile,
+            trajectory_file,
+            sampling);
+
+    dispatcher.run_dispatcher();
+} // run_reaction_network()
+
+/* ---------------------------------------------------------------------- */
+
+template <typename Solver>
+void run_energy_reaction_network(char *reaction_database,
+                                 char *initial_state_database,
+                                 int number_of_simulations,
+                                 int base_seed,
+                                 int thread_count,
+                                 Cutoff cutoff,
+                                 EnergyReactionNetworkParameters parameters,
+                                 SqlWriteProfile write_profile,
+                                 std::string trajectory_file,
+                                 Sampling sampling)
+{
+    Dispatcher<
+        Solver,
+        EnergyReactionNetwork,
+        EnergyReactionNetworkParameters,
+        ReactionNetworkWriteTrajectoriesSql,
+        ReactionNetworkReadTrajectoriesSql,
+        ReactionNetworkWriteStateSql,
+        ReactionNetworkReadStateSql,
+        EnergyNetworkWriteCutoffSql,
+        EnergyNetworkReadCutoffSql,
+        ReactionNetworkStateHistoryElement,
+        ReactionNetworkTrajectoryHistoryElement,
+        EnergyNetworkCutoffHistoryElement,
+        EnergyReactionNetworkSimulation<Solver>,
+        EnergyState>
+
+        dispatcher(
+            reaction_database,
+            initial_state_database,
+            number_of_simulations,
+            base_seed,
+            thread_count,
+            cutoff,
+            parameters,
+            write_profile,
+            trajectory_file,
+            sampling);
+
+    dispatcher.run_dispatcher();
+} // run_energy_reaction_network()
+
+/* ---------------------------------------------------------------------- */
+
 int main(int argc, char **argv)
 {
     // Print options if incorrect number of args are supplied
-    if (argc < 8 || argc > 9)
+    if (argc < 8 || argc > 14)
     {
         print_usage();
         exit(EXIT_FAILURE);
@@ -47,6 +150,11 @@ int main(int argc, char **argv)
         {"time_cutoff", optional_argument, NULL, 7},
         {"energy_budget", optional_argument, NULL, 8},
         {"checkpoint", required_argument, NULL, 9},
+        {"solver", required_argument, NULL, 10},
+        {"synchronous", required_argument, NULL, 11},
+        {"trajectory_file", required_argument, NULL, 12},
+        {"sample_interval", required_argument, NULL, 13},
+        {"sample_species", required_argument, NULL, 14},
         {NULL, 0, NULL, 0}};
 
     int c;
@@ -59,6 +167,11 @@ int main(int argc, char **argv)
     int thread_count = 0;
     double energy_budget = 0;
     bool isCheckpoint = false;
+    std::string solver = "";
+    std::string synchronous = "normal";
+    std::string trajectory_file = "";
+    double sample_interval = 0.0;
+    std::vector<int> sample_species;
 
     Cutoff cutoff = {
         .bound = {.step = 0},
@@ -111,6 +224,53 @@ int main(int argc, char **argv)
             isCheckpoint = atof(optarg);
             break;
 
+        case 10:
+            solver = optarg;
+            break;
+
+        case 11:
+            synchronous = optarg;
+            break;
+
+        case 12:
+            trajectory_file = optarg;
+            break;
+
+        case 13:
+        {
+            char *end;
+            sample_interval = strtod(optarg, &end);
+            if (*optarg == '\0' || *end != '\0' ||
+                !std::isfinite(sample_interval) || sample_interval <= 0.0)
+            {
+                std::cout << "sample_interval must be a positive number, got "
+                          << optarg << "\n";
+                print_usage();
+                exit(EXIT_FAILURE);
+            }
+            break;
+        }
+
+        case 14:
+        {
+            std::stringstream species_ids(optarg);
+            std::string species_id;
+            while (std::getline(species_ids, species_id, ','))
+            {
+                char *end;
+                long int id = strtol(species_id.c_str(), &end, 10);
+                if (species_id.empty() || *end != '\0' || id < 0 || id > INT_MAX)
+                {
+                    std::cout << "sample_species must be a comma separated list of species ids, got "
+                              << optarg << "\n";
+                    print_usage();
+                    exit(EXIT_FAILURE);
+                }
+                sample_species.push_back(id);
+            }
+            break;
+        }
+
         default:
             // if an unexpected argument is passed, exit
             print_usage();
@@ -119,38 +279,80 @@ int main(int argc, char **argv)
         }
     }
 
+    if (synchronous != "normal" && synchronous != "off")
+    {
+        std::cout << "Unknown synchronous mode: " << synchronous << "\n";
+        print_usage();
+        exit(EXIT_FAILURE);
+    }
+
+    if (sample_interval == 0.0 && !sample_species.empty())
+    {
+        std::cout << "sample_species requires sample_interval\n";
+        print_usage();
+        exit(EXIT_FAILURE);
+    }
+
+    // sampled runs write no trajectories
+    if (sample_interval > 0.0 && !trajectory_file.empty())
+    {
+        std::cout << "sample_interval and trajectory_file cannot be used together\n";
+        print_usage();
+        exit(EXIT_FAILURE);
+    }
+
+    // with a time cutoff the samples go up to the cutoff, even if the
+    // reactions run out before
+    Sampling sampling{
+        .interval = sample_interval,
+        .end = cutoff.type_of_cutoff == time_termination
+                   ? cutoff.bound.time
+                   : std::numeric_limits<double>::infinity(),
+        .species = sample_species};
+
+    SqlWriteProfile write_profile{
+        .synchronous = synchronous == "off" ? "OFF" : "NORMAL",
+        .cache_size_mib = default_cache_size_mib,
+        .mmap_size_mib = default_mmap_size_mib};
+
     // Normal GMC if no energy budget is specified
     if (energy_budget == 0)
     {
         ReactionNetworkParameters parameters{
             .isCheckpoint = isCheckpoint};
 
-        Dispatcher<
-            LinearSolver,
-            GillespieReactionNetwork,
-            ReactionNetworkParameters,
-            ReactionNetworkWriteTrajectoriesSql,
-            ReactionNetworkReadTrajectoriesSql,
-            ReactionNetworkWriteStateSql,
-            ReactionNetworkReadStateSql,
-            WriteCutoffSql,
-            ReadCutoffSql,
-            ReactionNetworkStateHistoryElement,
-            ReactionNetworkTrajectoryHistoryElement,
-            CutoffHistoryElement,
-            ReactionNetworkSimulation<LinearSolver>,
-            std::vector<int>>
-
-            dispatcher(
-                reaction_database,
-                initial_state_database,
-                number_of_simulations,
-                base_seed,
-                thread_count,
-                cutoff,
-                parameters);
-
-        dispatcher.run_dispatcher();
+        // linear solver is the default for normal GMC
+        if (solver == "" || solver == "linear")
+            run_reaction_network<LinearSolver>(reaction_database, initial_state_database,
+                                               number_of_simulations, base_seed,
+                                               thread_count, cutoff, parameters,
+                                               write_profile, trajectory_file, sampling);
+        else if (solver == "tree")
+            run_reaction_network<TreeSolver>(reaction_database, initial_state_database,
+                                             number_of_simulations, base_seed,
+                                             thread_count, cutoff, parameters,
+                                             write_profile, trajectory_file, sampling);
+        else if (solver == "kary_tree")
+            run_reaction_network<KaryTreeSolver>(reaction_database, initial_state_database,
+                                                 number_of_simulations, base_seed,
+                                                 thread_count, cutoff, parameters,
+                                                 write_profile, trajectory_file, sampling);
+        else if (solver == "sparse")
+            run_reaction_network<SparseSolver>(reaction_database, initial_state_database,
+                                               number_of_simulations, base_seed,
+                                               thread_count, cutoff, parameters,
+                                               write_profile, trajectory_file, sampling);
+        else if (solver == "composition_rejection")
+            run_reaction_network<CompositionRejectionSolver>(reaction_database, initial_state_database,
+                                                             number_of_simulations, base_seed,
+                                                             thread_count, cutoff, parameters,
+                                                             write_profile, trajectory_file, sampling);
+        else
+        {
+            std::cout << "Unknown solver: " << solver << "\n";
+            print_usage();
+            exit(EXIT_FAILURE);
+        }
     }
     else
     {
@@ -159,33 +361,38 @@ int main(int argc, char **argv)
             .energy_budget = energy_budget,
             .isCheckpoint = isCheckpoint};
 
-        Dispatcher<
-            LinearSolver,
-            EnergyReactionNetwork,
-            EnergyReactionNetworkParameters,
-            ReactionNetworkWriteTrajectoriesSql,
-            ReactionNetworkReadTrajectoriesSql,
-            ReactionNetworkWriteStateSql,
-            ReactionNetworkReadStateSql,
-            EnergyNetworkWriteCutoffSql,
-            EnergyNetworkReadCutoffSql,
-            ReactionNetworkStateHistoryElement,
-            ReactionNetworkTrajectoryHistoryElement,
-            EnergyNetworkCutoffHistoryElement,
-            EnergyReactionNetworkSimulation<TreeSolver>,
-            EnergyState>
-
-            dispatcher(
-                reaction_database,
-                initial_state_database,
-                number_of_simulations,
-                base_seed,
-                thread_count,
-                cutoff,
-                parameters);
-
-        // run the simulation
-        dispatcher.run_dispatcher();
+        // tree solver is the default when an energy budget is specified
+        if (solver == "" || solver == "tree")
+            run_energy_reaction_network<TreeSolver>(reaction_database, initial_state_database,
+                                                    number_of_simulations, base_seed,
+                                                    thread_count, cutoff, parameters,
+                                                    write_profile, trajectory_file, sampling);
+        else if (solver == "linear")
+            run_energy_reaction_network<LinearSolver>(reaction_database, initial_state_database,
+                                                      number_of_simulations, base_seed,
+                                                      thread_count, cutoff, parameters,
+                                                      write_profile, trajectory_file, sampling);
+        else if (solver == "kary_tree")
+            run_energy_reaction_network<KaryTreeSolver>(reaction_database, initial_state_database,
+                                                        number_of_simulations, base_seed,
+                                                        thread_count, cutoff, parameters,
+                                                        write_profile, trajectory_file, sampling);
+        else if (solver == "sparse")
+            run_energy_reaction_network<SparseSolver>(reaction_database, initial_state_database,
+                                                      number_of_simulations, base_seed,
+                                                      thread_count, cutoff, parameters,
+                                                      write_profile, trajectory_file, sampling);
+        else if (solver == "composition_rejection")
+            run_energy_reaction_network<CompositionRejectionSolver>(reaction_database, initial_state_database,
+                                                                    number_of_simulations, base_seed,
+                                                                    thread_count, cutoff, parameters,
+                                                                    write_profile, trajectory_file, sampling);
+        else
+        {
+            std::cout << "Unknown solver: " << solver << "\n";
+            print_usage();
+            exit(EXIT_FAILURE);
+        }
     }
 
     exit(EXIT_SUCCESS);
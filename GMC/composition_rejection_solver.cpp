@@ -0,0 +1,196 @@
+/* ----------------------------------------------------------------------
+RNMC - Reaction Network Monte Carlo
+https://blaugroup.github.io/RNMC/
+
+See the README file in the top-level RNMC directory.
+---------------------------------------------------------------------- */
+
+#include "composition_rejection_solver.h"
+
+// binary exponents of positive doubles lie in [-1073, 1024]
+constexpr int exponent_offset = 1100;
+constexpr int number_of_exponents = 2200;
+
+/*---------------------------------------------------------------------------
+CompositionRejectionSolver implementation
+CompositionRejectionSolver always copies the initial propensities into a new array.
+---------------------------------------------------------------------------*/
+CompositionRejectionSolver::CompositionRejectionSolver(
+    unsigned long int seed,
+    std::vector<double> &initial_propensities) : sampler(Sampler(seed)),
+                                                 propensities(initial_propensities),
+                                                 group_of_exponent(number_of_exponents, -1),
+                                                 index_group(initial_propensities.size(), -1),
+                                                 index_position(initial_propensities.size(), 0),
+                                                 number_of_active_indices(0),
+                                                 propensity_sum(0.0)
+{
+    for (unsigned long int i = 0; i < propensities.size(); i++)
+    {
+        if (propensities[i] > 0.0)
+        {
+            insert(i);
+            propensity_sum += propensities[i];
+        }
+    }
+} // CompositionRejectionSolver()
+
+/*---------------------------------------------------------------------------*/
+
+int CompositionRejectionSolver::find_group(double propensity)
+{
+    int exponent;
+    std::frexp(propensity, &exponent);
+
+    int &group = group_of_exponent[exponent + exponent_offset];
+    if (group < 0)
+    {
+        group = groups.size();
+        groups.push_back(CompositionRejectionGroup{
+            .exponent = exponent,
+            .upper_bound = std::ldexp(1.0, exponent),
+            .propensity_sum = 0.0,
+            .members = {}});
+    }
+
+    return group;
+} // find_group()
+
+/*---------------------------------------------------------------------------*/
+
+void CompositionRejectionSolver::insert(unsigned long int index)
+{
+    int group = find_group(propensities[index]);
+    CompositionRejectionGroup &g = groups[group];
+
+    index_group[index] = group;
+    index_position[index] = g.members.size();
+    g.members.push_back(index);
+    g.propensity_sum += propensities[index];
+    number_of_active_indices++;
+} // insert()
+
+/*---------------------------------------------------------------------------*/
+
+void CompositionRejectionSolver::remove(unsigned long int index)
+{
+    CompositionRejectionGroup &g = groups[index_group[index]];
+
+    // move the last member into the vacated slot
+    unsigned long int position = index_position[index];
+    unsigned long int last = g.members.back();
+    g.members[position] = last;
+    index_position[last] = position;
+    g.members.pop_back();
+
+    // an empty group has no rounding error left over
+    if (g.members.empty())
+        g.propensity_sum = 0.0;
+    else
+        g.propensity_sum -= propensities[index];
+
+    index_group[index] = -1;
+    number_of_active_indices--;
+} // remove()
+
+/*---------------------------------------------------------------------------*/
+
+void CompositionRejectionSolver::update(Update update)
+{
+    double old_propensity = propensities[update.index];
+
+    if (index_group[update.index] >= 0)
+    {
+        // the index stays in its group if its exponent is unchanged
+        if (update.propensity > 0.0 &&
+            groups[index_group[update.index]].exponent == std::ilogb(update.propensity) + 1)
+        {
+            groups[index_group[update.index]].propensity_sum += update.propensity - old_propensity;
+            propensities[update.index] = update.propensity;
+            propensity_sum += update.propensity - old_propensity;
+            return;
+        }
+
+        remove(update.index);
+    }
+
+    propensities[update.index] = update.propensity;
+    if (update.propensity > 0.0)
+        insert(update.index);
+
+    propensity_sum -= old_propensity;
+    propensity_sum += update.propensity;
+} // update()
+
+/*---------------------------------------------------------------------------*/
+
+void CompositionRejectionSolver::update(const std::vector<Update> &updates)
+{
+    for (Update u : updates)
+        update(u);
+} // update()
+
+/*---------------------------------------------------------------------------*/
+
+std::optional<Event> CompositionRejectionSolver::event()
+{
+    if (number_of_active_indices == 0)
+    {
+        propensity_sum = 0.0;
+        return std::optional<Event>();
+    }
+
+    double r1 = sampler.generate();
+    double r2 = sampler.generate();
+    double fraction = propensity_sum * r1;
+    double partial = 0.0;
+
+    // composition: pick a group proportional to its propensity sum.
+    // if rounding error means we run off the end, fall back to the
+    // last non empty group.
+    int selected = -1;
+    for (unsigned int g = 0; g < groups.size(); g++)
+    {
+        if (groups[g].members.empty())
+            continue;
+
+        selected = g;
+        partial += groups[g].propensity_sum;
+        if (partial > fraction)
+            break;
+    }
+
+    // rejection: pick a member uniformly and accept it with probability
+    // propensity / upper_bound, which is at least 1/2.
+    CompositionRejectionGroup &group = groups[selected];
+    unsigned long int m;
+    while (true)
+    {
+        double r3 = sampler.generate();
+        double r4 = sampler.generate();
+        unsigned long int position = static_cast<unsigned long int>(r3 * group.members.size());
+        if (position >= group.members.size())
+            position = group.members.size() - 1;
+
+        m = group.members[position];
+        if (r4 * group.upper_bound < propensities[m])
+            break;
+    }
+
+    double dt = -std::log(r2) / propensity_sum;
+    return std::optional<Event>(Event{.index = m, .dt = dt});
+} // event()
+
+/*---------------------------------------------------------------------------*/
+
+double CompositionRejectionSolver::get_propensity(int index)
+{
+    return propensities[index];
+} // get_propensity()
+
+/*---------------------------------------------------------------------------*/
+
+double CompositionRejectionSolver::get_propensity_sum()
+{
+    return propensity_sum;
+} // get_propensity_sum()
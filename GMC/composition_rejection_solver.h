@@ -0,0 +1,61 @@
+/* ----------------------------------------------------------------------
+RNMC - Reaction Network Monte Carlo
+https://blaugroup.github.io/RNMC/
+
+See the README file in the top-level RNMC directory.
+---------------------------------------------------------------------- */
+
+#ifndef RNMC_COMPOSITION_REJECTION_SOLVER_H
+#define RNMC_COMPOSITION_REJECTION_SOLVER_H
+
+#include <vector>
+#include <optional>
+#include <cmath>
+#include <map>
+
+#include "../core/sampler.h"
+#include "../core/RNMC_types.h"
+
+// composition rejection solver (Slepoy, Thompson and Plimpton 2008).
+// propensities are binned into groups [2^(e-1), 2^e) by their binary
+// exponent e. An event is chosen by first picking a group with a scan
+// over the (small, bounded) set of groups and then picking a member of
+// that group by rejection sampling against the group upper bound 2^e,
+// which accepts with probability at least 1/2. Updates move an index
+// between groups in O(1) by swapping with the last member.
+
+struct CompositionRejectionGroup
+{
+    int exponent;                  // members have propensity in [2^(exponent-1), 2^exponent)
+    double upper_bound;            // 2^exponent
+    double propensity_sum;         // sum of member propensities
+    std::vector<unsigned long int> members;
+};
+
+class CompositionRejectionSolver
+{
+private:
+    Sampler sampler;
+    std::vector<double> propensities;
+    std::vector<CompositionRejectionGroup> groups;
+    std::vector<int> group_of_exponent; // maps exponent to index in groups, -1 if none
+    std::vector<int> index_group;                  // group of each index, -1 if propensity is zero
+    std::vector<unsigned long int> index_position; // position of each index in its group
+    int number_of_active_indices;                  // an index is active if its propensity is non zero
+    double propensity_sum;
+
+    int find_group(double propensity);
+    void insert(unsigned long int index);
+    void remove(unsigned long int index);
+
+public:
+    CompositionRejectionSolver() : sampler(Sampler(0)){}; // default constructor
+    CompositionRejectionSolver(unsigned long int seed, std::vector<double> &initial_propensities);
+    void update(Update update);
+    void update(const std::vector<Update> &updates);
+    std::optional<Event> event();
+    double get_propensity(int index);
+    double get_propensity_sum();
+};
+
+#endif
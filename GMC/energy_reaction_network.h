@@ -8,6 +8,8 @@ See the README file in the top-level RNMC directory.
 #ifndef ENERGY_REACTION_NETWORK_H
 #define ENERGY_REACTION_NETWORK_H
 
+#include <algorithm>
+
 #include "reaction_network.h"
 #include "sql_types.h"
 
@@ -44,20 +46,38 @@ public:
     bool isCheckpoint;
     EnergyState initial_state;
 
+    // reaction ids sorted by dG, and the dG of each, so the reactions
+    // switched on or off when the energy budget changes are found by
+    // binary search instead of recomputing every propensity.
+    std::vector<int> reactions_by_dG;
+    std::vector<double> sorted_dG;
+
     EnergyReactionNetwork(
         SqlConnection &reaction_network_database,
         SqlConnection &initial_state_database,
         EnergyReactionNetworkParameters parameters);
 
+    void compute_reactions_by_dG();
+
     double compute_energy_propensity(
         std::vector<int> &state,
         int reaction,
         double energy_budget);
 
+    void compute_initial_energy_propensities(
+        std::vector<int> &state,
+        double energy_budget,
+        std::vector<double> &initial_propensities);
+
+    // the sink is usually the solver itself, any type with an
+    // update(Update) method works. previous_energy_budget is the
+    // budget before next_reaction fired.
+    template <typename UpdateSink>
     void update_propensities(
-        std::function<void(Update update)> update_function,
+        UpdateSink &update_sink,
         std::vector<int> &state,
         int next_reaction,
+        double previous_energy_budget,
         double energy_budget);
 
     void update_energy_budget(
@@ -69,7 +89,6 @@ public:
                     SqlReader<ReactionNetworkReadTrajectoriesSql> trajectory_reader,
                     std::map<int, EnergyState> &temp_seed_state_map,
                     std::map<int, int> &temp_seed_step_map,
-                    SeedQueue &temp_seed_queue,
                     std::map<int, double> &temp_seed_time_map,
                     EnergyReactionNetwork &model);
 
@@ -177,10 +196,33 @@ EnergyReactionNetwork::EnergyReactionNetwork(
 
     std::cerr << time::time_stamp() << "finished computing dependency graph\n";
 
+    compute_reactions_by_dG();
+
 } // EnergyReactionNetwork()
 
 /*---------------------------------------------------------------------------*/
 
+void EnergyReactionNetwork::compute_reactions_by_dG()
+{
+    reactions_by_dG.resize(reactions.size());
+    for (unsigned int reaction_index = 0; reaction_index < reactions.size(); reaction_index++)
+    {
+        reactions_by_dG[reaction_index] = reaction_index;
+    }
+
+    std::sort(reactions_by_dG.begin(), reactions_by_dG.end(),
+              [&](int a, int b)
+              { return reactions[a].dG < reactions[b].dG; });
+
+    sorted_dG.resize(reactions.size());
+    for (unsigned int i = 0; i < reactions_by_dG.size(); i++)
+    {
+        sorted_dG[i] = reactions[reactions_by_dG[i]].dG;
+    }
+} // compute_reactions_by_dG()
+
+/*---------------------------------------------------------------------------*/
+
 double EnergyReactionNetwork::compute_energy_propensity(
     std::vector<int> &state,
     int reaction_index,
@@ -209,33 +251,35 @@ double EnergyReactionNetwork::compute_energy_propensity(
 
 /*---------------------------------------------------------------------------*/
 
+void EnergyReactionNetwork::compute_initial_energy_propensities(
+    std::vector<int> &state,
+    double energy_budget,
+    std::vector<double> &initial_propensities)
+{
+    initial_propensities.resize(reactions.size());
+
+    for (unsigned long int i = 0; i < initial_propensities.size(); i++)
+    {
+        initial_propensities[i] = compute_energy_propensity(state, i, energy_budget);
+    }
+} // compute_initial_energy_propensities()
+
+/*---------------------------------------------------------------------------*/
+
+template <typename UpdateSink>
 void EnergyReactionNetwork::update_propensities(
-    std::function<void(Update update)> update_function,
+    UpdateSink &update_sink,
     std::vector<int> &state,
     int next_reaction,
+    double previous_energy_budget,
     double energy_budget)
 {
 
     EnergyReaction &reaction = reactions[next_reaction];
 
-    std::vector<int> species_of_interest;
-    species_of_interest.reserve(4);
-
-    for (int i = 0; i < reaction.number_of_reactants; i++)
-    {
-        int reactant_id = reaction.reactants[i];
-        species_of_interest.push_back(reactant_id);
-    }
-
-    for (int j = 0; j < reaction.number_of_products; j++)
-    {
-        int product_id = reaction.products[j];
-        species_of_interest.push_back(product_id);
-    }
-
     // Update the propensities for reactions corresponding to species
     // which were produced or consumed
-    for (int species_id : species_of_interest)
+    auto update_dependents = [&](int species_id)
     {
         for (unsigned int reaction_index : dependents[species_id])
         {
@@ -244,24 +288,40 @@ void EnergyReactionNetwork::update_propensities(
                 reaction_index,
                 energy_budget);
 
-            update_function(Update{
+            update_sink.update(Update{
                 .index = reaction_index,
                 .propensity = new_propensity});
         }
-    }
+    };
 
-    // We'll need to update the propensities for all reactions which have
-    // a dG > energy_budget
-    for (unsigned int reaction_index = 0; reaction_index < reactions.size(); reaction_index++)
+    for (int i = 0; i < reaction.number_of_reactants; i++)
+        update_dependents(reaction.reactants[i]);
+
+    for (int j = 0; j < reaction.number_of_products; j++)
+        update_dependents(reaction.products[j]);
+
+    // When the energy budget changed, only the reactions whose dG lies
+    // between the old and the new budget were switched on or off
+    if (energy_budget != previous_energy_budget)
     {
-        double new_propensity = compute_energy_propensity(
-            state,
-            reaction_index,
-            energy_budget);
-
-        update_function(Update{
-            .index = reaction_index,
-            .propensity = new_propensity});
+        double low = std::min(previous_energy_budget, energy_budget);
+        double high = std::max(previous_energy_budget, energy_budget);
+
+        auto first = std::upper_bound(sorted_dG.begin(), sorted_dG.end(), low);
+        auto last = std::upper_bound(first, sorted_dG.end(), high);
+
+        for (auto it = first; it != last; it++)
+        {
+            unsigned int reaction_index = reactions_by_dG[it - sorted_dG.begin()];
+            double new_propensity = compute_energy_propensity(
+                state,
+                reaction_index,
+                energy_budget);
+
+            update_sink.update(Update{
+                .index = reaction_index,
+                .propensity = new_propensity});
+        }
     }
 } // update_propensities()
 
@@ -289,20 +349,17 @@ void EnergyReactionNetwork::checkpoint(SqlReader<ReactionNetworkReadStateSql> st
                                        SqlReader<ReactionNetworkReadTrajectoriesSql> trajectory_reader,
                                        std::map<int, EnergyState> &temp_seed_state_map,
                                        std::map<int, int> &temp_seed_step_map,
-                                       SeedQueue &temp_seed_queue,
                                        std::map<int, double> &temp_seed_time_map,
                                        EnergyReactionNetwork &model)
 {
 
     bool read_interrupt_states = false;
-    EnergyState default_state = model.initial_state;
-
-    while (std::optional<unsigned long int> maybe_seed =
-               temp_seed_queue.get_seed())
+    // only seeds with a checkpoint get an entry, starting from a copy
+    // of initial_state. the other seeds copy initial_state when they run.
+    auto seed_state = [&](int seed) -> EnergyState &
     {
-        unsigned long int seed = maybe_seed.value();
-        temp_seed_state_map.insert(std::make_pair(seed, default_state));
-    }
+        return temp_seed_state_map.try_emplace(seed, model.initial_state).first->second;
+    };
 
     while (std::optional<EnergyNetworkReadCutoffSql> maybe_cutoff_row = cutoff_reader.next())
     {
@@ -310,7 +367,7 @@ void EnergyReactionNetwork::checkpoint(SqlReader<ReactionNetworkReadStateSql> st
 
         temp_seed_step_map[cutoff_row.seed] = cutoff_row.step;
         temp_seed_time_map[cutoff_row.seed] = cutoff_row.time;
-        temp_seed_state_map[cutoff_row.seed].energy_budget = cutoff_row.energy_budget;
+        seed_state(cutoff_row.seed).energy_budget = cutoff_row.energy_budget;
     }
 
     while (std::optional<ReactionNetworkReadStateSql> maybe_state_row = state_reader.next())
@@ -318,7 +375,7 @@ void EnergyReactionNetwork::checkpoint(SqlReader<ReactionNetworkReadStateSql> st
         read_interrupt_states = true;
 
         ReactionNetworkReadStateSql state_row = maybe_state_row.value();
-        temp_seed_state_map[state_row.seed].homogeneous[state_row.species_id] = state_row.count;
+        seed_state(state_row.seed).homogeneous[state_row.species_id] = state_row.count;
     }
 
     if (!read_interrupt_states && isCheckpoint)
@@ -332,14 +389,14 @@ void EnergyReactionNetwork::checkpoint(SqlReader<ReactionNetworkReadStateSql> st
             // update reactants
             for (int i = 0; i < reaction.number_of_reactants; i++)
             {
-                temp_seed_state_map[trajectory_row.seed].homogeneous[reaction.reactants[i]] =
-                    temp_seed_state_map[trajectory_row.seed].homogeneous[reaction.reactants[i]] - 1;
+                seed_state(trajectory_row.seed).homogeneous[reaction.reactants[i]] =
+                    seed_state(trajectory_row.seed).homogeneous[reaction.reactants[i]] - 1;
             }
             // update products
             for (int i = 0; i < reaction.number_of_products; i++)
             {
-                temp_seed_state_map[trajectory_row.seed].homogeneous[reaction.products[i]] =
-                    temp_seed_state_map[trajectory_row.seed].homogeneous[reaction.products[i]] + 1;
+                seed_state(trajectory_row.seed).homogeneous[reaction.products[i]] =
+                    seed_state(trajectory_row.seed).homogeneous[reaction.products[i]] + 1;
             }
 
             if (trajectory_row.step > temp_seed_step_map[trajectory_row.seed])
@@ -41,8 +41,15 @@ public:
         SqlConnection &initial_state_database,
         ReactionNetworkParameters parameters);
 
+    // the new propensities are collected in updates, which is cleared
+    // first so a simulation can reuse it every step, and sent to the
+    // update sink as a single batch. the sink is usually the solver
+    // itself, any type with an update(const std::vector<Update> &)
+    // method works.
+    template <typename UpdateSink>
     void update_propensities(
-        std::function<void(Update update)> update_function,
+        UpdateSink &update_sink,
+        std::vector<Update> &updates,
         std::vector<int> &state,
         int next_reaction);
 
@@ -51,7 +58,6 @@ public:
                     SqlReader<ReactionNetworkReadTrajectoriesSql> trajectory_reader,
                     std::map<int, std::vector<int>> &temp_seed_state_map,
                     std::map<int, int> &temp_seed_step_map,
-                    SeedQueue &temp_seed_queue,
                     std::map<int, double> &temp_seed_time_map,
                     GillespieReactionNetwork &model);
 
@@ -150,30 +156,19 @@ GillespieReactionNetwork::GillespieReactionNetwork(
 
 /*---------------------------------------------------------------------------*/
 
+template <typename UpdateSink>
 void GillespieReactionNetwork::update_propensities(
-    std::function<void(Update update)> update_function,
+    UpdateSink &update_sink,
+    std::vector<Update> &updates,
     std::vector<int> &state,
     int next_reaction)
 {
 
     GillespieReaction &reaction = reactions[next_reaction];
 
-    std::vector<int> species_of_interest;
-    species_of_interest.reserve(4);
+    updates.clear();
 
-    for (int i = 0; i < reaction.number_of_reactants; i++)
-    {
-        int reactant_id = reaction.reactants[i];
-        species_of_interest.push_back(reactant_id);
-    }
-
-    for (int j = 0; j < reaction.number_of_products; j++)
-    {
-        int product_id = reaction.products[j];
-        species_of_interest.push_back(product_id);
-    }
-
-    for (int species_id : species_of_interest)
+    auto add_dependents = [&](int species_id)
     {
         for (unsigned int reaction_index : dependents[species_id])
         {
@@ -182,11 +177,19 @@ void GillespieReactionNetwork::update_propensities(
                 state,
                 reaction_index);
 
-            update_function(Update{
+            updates.push_back(Update{
                 .index = reaction_index,
                 .propensity = new_propensity});
         }
-    }
+    };
+
+    for (int i = 0; i < reaction.number_of_reactants; i++)
+        add_dependents(reaction.reactants[i]);
+
+    for (int j = 0; j < reaction.number_of_products; j++)
+        add_dependents(reaction.products[j]);
+
+    update_sink.update(updates);
 } // update_propensities()
 
 /*---------------------------------------------------------------------------*/
@@ -196,20 +199,17 @@ void GillespieReactionNetwork::checkpoint(SqlReader<ReactionNetworkReadStateSql>
                                           SqlReader<ReactionNetworkReadTrajectoriesSql> trajectory_reader,
                                           std::map<int, std::vector<int>> &temp_seed_state_map,
                                           std::map<int, int> &temp_seed_step_map,
-                                          SeedQueue &temp_seed_queue,
                                           std::map<int, double> &temp_seed_time_map,
                                           GillespieReactionNetwork &model)
 {
 
     bool read_interrupt_states = false;
-    std::vector<int> default_state = model.initial_state;
-
-    while (std::optional<unsigned long int> maybe_seed =
-               temp_seed_queue.get_seed())
+    // only seeds with a checkpoint get an entry, starting from a copy
+    // of initial_state. the other seeds copy initial_state when they run.
+    auto seed_state = [&](int seed) -> std::vector<int> &
     {
-        unsigned long int seed = maybe_seed.value();
-        temp_seed_state_map.insert(std::make_pair(seed, default_state));
-    }
+        return temp_seed_state_map.try_emplace(seed, model.initial_state).first->second;
+    };
 
     while (std::optional<ReadCutoffSql> maybe_cutoff_row = cutoff_reader.next())
     {
@@ -224,7 +224,7 @@ void GillespieReactionNetwork::checkpoint(SqlReader<ReactionNetworkReadStateSql>
         read_interrupt_states = true;
 
         ReactionNetworkReadStateSql state_row = maybe_state_row.value();
-        temp_seed_state_map[state_row.seed][state_row.species_id] = state_row.count;
+        seed_state(state_row.seed)[state_row.species_id] = state_row.count;
     }
 
     if (!read_interrupt_states && isCheckpoint)
@@ -238,14 +238,14 @@ void GillespieReactionNetwork::checkpoint(SqlReader<ReactionNetworkReadStateSql>
             // update reactants
             for (int i = 0; i < reaction.number_of_reactants; i++)
             {
-                temp_seed_state_map[trajectory_row.seed][reaction.reactants[i]] =
-                    temp_seed_state_map[trajectory_row.seed][reaction.reactants[i]] - 1;
+                seed_state(trajectory_row.seed)[reaction.reactants[i]] =
+                    seed_state(trajectory_row.seed)[reaction.reactants[i]] - 1;
             }
             // update products
             for (int i = 0; i < reaction.number_of_products; i++)
             {
-                temp_seed_state_map[trajectory_row.seed][reaction.products[i]] =
-                    temp_seed_state_map[trajectory_row.seed][reaction.products[i]] + 1;
+                seed_state(trajectory_row.seed)[reaction.products[i]] =
+                    seed_state(trajectory_row.seed)[reaction.products[i]] + 1;
             }
 
             if (trajectory_row.step > temp_seed_step_map[trajectory_row.seed])
@@ -0,0 +1,219 @@
+/* ----------------------------------------------------------------------
+RNMC - Reaction Network Monte Carlo
+https://blaugroup.github.io/RNMC/
+
+See the README file in the top-level RNMC directory.
+---------------------------------------------------------------------- */
+
+#include "kary_tree_solver.h"
+
+/*---------------------------------------------------------------------------*/
+
+static double node_sum(const KaryTreeNode &node)
+{
+    double sum = 0.0;
+    for (int k = 0; k < kary_width; k++)
+        sum += node.child[k];
+    return sum;
+} // node_sum()
+
+/*---------------------------------------------------------------------------
+KaryTreeSolver implementation
+KaryTreeSolver always copies the initial propensities into a new array.
+---------------------------------------------------------------------------*/
+KaryTreeSolver::KaryTreeSolver(
+    unsigned long int seed,
+    std::vector<double> &initial_propensities) : sampler(Sampler(seed)),
+                                                 number_of_active_indices(0),
+                                                 propensity_sum(0.0)
+{
+    number_of_indices = initial_propensities.size();
+
+    // the leaves hold kary_width propensities per node and every level
+    // above holds the sums of kary_width nodes of the level below.
+    int number_of_nodes = (number_of_indices + kary_width - 1) / kary_width;
+    if (number_of_nodes == 0)
+        number_of_nodes = 1;
+
+    int total_nodes = 0;
+    while (true)
+    {
+        level_offset.push_back(total_nodes);
+        total_nodes += number_of_nodes;
+        if (number_of_nodes == 1)
+            break;
+        number_of_nodes = (number_of_nodes + kary_width - 1) / kary_width;
+    }
+
+    tree.resize(total_nodes, KaryTreeNode{});
+
+    for (int i = 0; i < number_of_indices; i++)
+    {
+        tree[i / kary_width].child[i % kary_width] = initial_propensities[i];
+        if (initial_propensities[i] > 0.0)
+            number_of_active_indices++;
+    }
+
+    for (unsigned int level = 1; level < level_offset.size(); level++)
+    {
+        for (int j = 0; j < level_offset[level] - level_offset[level - 1]; j++)
+        {
+            tree[level_offset[level] + j / kary_width].child[j % kary_width] =
+                node_sum(tree[level_offset[level - 1] + j]);
+        }
+    }
+
+    propensity_sum = node_sum(tree.back());
+} // KaryTreeSolver()
+
+/*---------------------------------------------------------------------------*/
+
+void KaryTreeSolver::update_ancestors(int node)
+{
+    for (unsigned int level = 1; level < level_offset.size(); level++)
+    {
+        int parent = node / kary_width;
+        tree[level_offset[level] + parent].child[node % kary_width] =
+            node_sum(tree[level_offset[level - 1] + node]);
+        node = parent;
+    }
+
+    // summing the root directly keeps the total free of accumulated
+    // rounding error
+    propensity_sum = node_sum(tree.back());
+} // update_ancestors()
+
+/*---------------------------------------------------------------------------*/
+
+void KaryTreeSolver::update(Update update)
+{
+    double &leaf = tree[update.index / kary_width].child[update.index % kary_width];
+
+    if (leaf > 0.0)
+        number_of_active_indices--;
+    if (update.propensity > 0.0)
+        number_of_active_indices++;
+    leaf = update.propensity;
+
+    update_ancestors(update.index / kary_width);
+} // update()
+
+/*---------------------------------------------------------------------------*/
+
+void KaryTreeSolver::update(const std::vector<Update> &updates)
+{
+    // write all the leaves first and remember which nodes changed
+    dirty_nodes.clear();
+    for (Update u : updates)
+    {
+        double &leaf = tree[u.index / kary_width].child[u.index % kary_width];
+        if (leaf > 0.0)
+            number_of_active_indices--;
+        if (u.propensity > 0.0)
+            number_of_active_indices++;
+        leaf = u.propensity;
+        dirty_nodes.push_back(u.index / kary_width);
+    }
+
+    // then recompute the slot of each dirty ancestor once, one level at
+    // a time. node indices are relative to their level, so taking parents
+    // preserves the order and the nodes only need to be sorted once.
+    std::sort(dirty_nodes.begin(), dirty_nodes.end());
+    dirty_nodes.erase(std::unique(dirty_nodes.begin(), dirty_nodes.end()),
+                      dirty_nodes.end());
+
+    for (unsigned int level = 1; level < level_offset.size(); level++)
+    {
+        for (int &node : dirty_nodes)
+        {
+            tree[level_offset[level] + node / kary_width].child[node % kary_width] =
+                node_sum(tree[level_offset[level - 1] + node]);
+            node = node / kary_width;
+        }
+
+        dirty_nodes.erase(std::unique(dirty_nodes.begin(), dirty_nodes.end()),
+                          dirty_nodes.end());
+    }
+
+    propensity_sum = node_sum(tree.back());
+} // update()
+
+/*---------------------------------------------------------------------------*/
+
+int KaryTreeSolver::find_solve_tree(double value)
+{
+    int j = 0;
+    for (int level = level_offset.size() - 1; level >= 0; level--)
+    {
+        const KaryTreeNode &node = tree[level_offset[level] + j];
+
+        double prefix[kary_width];
+        double partial = 0.0;
+        for (int k = 0; k < kary_width; k++)
+        {
+            partial += node.child[k];
+            prefix[k] = partial;
+        }
+
+        // the selected child is the first whose prefix sum reaches value,
+        // so count the prefix sums which fall short of it. this loop has
+        // no branches and compiles to packed compares.
+        int c = 0;
+        for (int k = 0; k < kary_width; k++)
+            c += prefix[k] < value;
+
+        // rounding error can push value past the last prefix sum.
+        // fall back to the last non zero child in that case.
+        if (c == kary_width)
+        {
+            c = kary_width - 1;
+            while (c > 0 && node.child[c] == 0.0)
+                c--;
+            value = prefix[c];
+        }
+
+        if (c > 0)
+            value -= prefix[c - 1];
+
+        j = j * kary_width + c;
+    }
+
+    return j;
+} // find_solve_tree()
+
+/*---------------------------------------------------------------------------*/
+
+std::optional<Event> KaryTreeSolver::event()
+{
+    unsigned long int m;
+    double r1, r2, dt;
+
+    if (number_of_active_indices == 0)
+    {
+        return std::optional<Event>();
+    }
+
+    r1 = sampler.generate();
+    r2 = sampler.generate();
+
+    double value = r1 * propensity_sum;
+
+    m = find_solve_tree(value);
+    dt = -log(r2) / propensity_sum;
+
+    return std::optional<Event>(Event{.index = m, .dt = dt});
+} // event()
+
+/*---------------------------------------------------------------------------*/
+
+double KaryTreeSolver::get_propensity(int index)
+{
+    return tree[index / kary_width].child[index % kary_width];
+} // get_propensity()
+
+/*---------------------------------------------------------------------------*/
+
+double KaryTreeSolver::get_propensity_sum()
+{
+    return propensity_sum;
+} // get_propensity_sum()
@@ -0,0 +1,61 @@
+/* ----------------------------------------------------------------------
+RNMC - Reaction Network Monte Carlo
+https://blaugroup.github.io/RNMC/
+
+See the README file in the top-level RNMC directory.
+---------------------------------------------------------------------- */
+
+#ifndef RNMC_KARY_TREE_SOLVER_H
+#define RNMC_KARY_TREE_SOLVER_H
+
+#include <vector>
+#include <optional>
+#include <cmath>
+#include <map>
+#include <algorithm>
+
+#include "../core/sampler.h"
+#include "../core/RNMC_types.h"
+
+// k-ary variant of the tree solver. every node of the tree stores the
+// propensity sums of its kary_width children next to each other in a
+// single cache line, so walking from the root to a leaf or from a leaf
+// to the root touches log_k(R) cache lines instead of log_2(R). the
+// child of a node is chosen by comparing the search value against all
+// the prefix sums of the node at once rather than branching on each.
+
+constexpr int kary_width = 8; // 8 doubles fill a 64 byte cache line
+
+struct alignas(64) KaryTreeNode
+{
+    double child[kary_width];
+};
+
+class KaryTreeSolver
+{
+private:
+    Sampler sampler;
+    std::vector<KaryTreeNode> tree; // levels stored leaves first, root last
+    std::vector<int> level_offset;  // index in tree of the first node of each level
+    int number_of_indices;
+    int number_of_active_indices; // an index is active if its propensity is non zero
+    double propensity_sum;
+    std::vector<int> dirty_nodes; // scratch space for batched updates
+
+    // recompute the slot of every ancestor of a leaf node
+    void update_ancestors(int node);
+
+    // walk tree from root to appropriate leaf
+    int find_solve_tree(double value);
+
+public:
+    KaryTreeSolver() : sampler(Sampler(0)){}; // default constructor
+    KaryTreeSolver(unsigned long int seed, std::vector<double> &initial_propensities);
+    void update(Update update);
+    void update(const std::vector<Update> &updates);
+    std::optional<Event> event();
+    double get_propensity(int index);
+    double get_propensity_sum();
+};
+
+#endif
@@ -21,11 +21,14 @@ LinearSolver::LinearSolver(
                                                   // call and that stack variable is copied into the object.
                                                   propensities(std::move(initial_propensities)),
                                                   number_of_active_indices(0),
-                                                  propensity_sum(0.0)
+                                                  propensity_sum(0.0),
+                                                  resync_interval(default_resync_interval),
+                                                  updates_since_resync(0),
+                                                  drift(0.0)
 {
     for (unsigned long i = 0; i < propensities.size(); i++)
     {
-        propensity_sum += propensities[i];
+        propensity_sum.add(propensities[i]);
         if (propensities[i] > 0)
         {
             number_of_active_indices += 1;
@@ -41,12 +44,15 @@ LinearSolver::LinearSolver(
     std::vector<double> &initial_propensities) : sampler(Sampler(seed)),
                                                  propensities(initial_propensities),
                                                  number_of_active_indices(0),
-                                                 propensity_sum(0.0)
+                                                 propensity_sum(0.0),
+                                                 resync_interval(default_resync_interval),
+                                                 updates_since_resync(0),
+                                                 drift(0.0)
 {
 
     for (unsigned long i = 0; i < propensities.size(); i++)
     {
-        propensity_sum += propensities[i];
+        propensity_sum.add(propensities[i]);
         if (propensities[i] > 0)
         {
             number_of_active_indices += 1;
@@ -70,14 +76,15 @@ void LinearSolver::update(Update update)
             last_non_zero_event = update.index;
     }
 
-    propensity_sum -= propensities[update.index];
-    propensity_sum += update.propensity;
+    propensity_sum.add(-propensities[update.index]);
+    propensity_sum.add(update.propensity);
     propensities[update.index] = update.propensity;
+    updates_since_resync++;
 } // update()
 
 /*---------------------------------------------------------------------------*/
 
-void LinearSolver::update(std::vector<Update> updates)
+void LinearSolver::update(const std::vector<Update> &updates)
 {
     for (Update u : updates)
     {
@@ -87,17 +94,38 @@ void LinearSolver::update(std::vector<Update> updates)
 
 /*---------------------------------------------------------------------------*/
 
+void LinearSolver::resync()
+{
+    CompensatedSum sum;
+    for (unsigned long i = 0; i < propensities.size(); i++)
+    {
+        sum.add(propensities[i]);
+    }
+
+    drift += std::fabs(sum.get() - propensity_sum.get());
+    propensity_sum = sum;
+    updates_since_resync = 0;
+} // resync()
+
+/*---------------------------------------------------------------------------*/
+
 std::optional<Event> LinearSolver::event()
 {
     if (number_of_active_indices == 0)
     {
-        propensity_sum = 0.0;
+        propensity_sum = CompensatedSum(0.0);
         return std::optional<Event>();
     }
 
+    // a non positive sum with active indices left can only be rounding
+    // error, so resync straight away
+    if (updates_since_resync >= resync_interval || !(propensity_sum.get() > 0))
+        resync();
+
+    double sum = propensity_sum.get();
     double r1 = sampler.generate();
     double r2 = sampler.generate();
-    double fraction = propensity_sum * r1;
+    double fraction = sum * r1;
     double partial = 0.0;
 
     unsigned long m;
@@ -109,7 +137,7 @@ std::optional<Event> LinearSolver::event()
             break;
     }
 
-    double dt = -std::log(r2) / propensity_sum;
+    double dt = -std::log(r2) / sum;
     if (m < propensities.size())
         return std::optional<Event>(Event{.index = m, .dt = dt});
     else
@@ -127,5 +155,19 @@ double LinearSolver::get_propensity(int index)
 
 double LinearSolver::get_propensity_sum()
 {
-    return propensity_sum;
-} // get_propensity_sum()
\ No newline at end of file
+    return propensity_sum.get();
+} // get_propensity_sum()
+
+/*---------------------------------------------------------------------------*/
+
+void LinearSolver::set_resync_interval(unsigned long int interval)
+{
+    resync_interval = interval;
+} // set_resync_interval()
+
+/*---------------------------------------------------------------------------*/
+
+double LinearSolver::get_drift()
+{
+    return drift;
+} // get_drift()
\ No newline at end of file
@@ -18,6 +18,7 @@ https://spparks.sandia.gov/
 
 #include "../core/sampler.h"
 #include "../core/RNMC_types.h"
+#include "../core/compensated_sum.h"
 
 #include <vector>
 #include <optional>
@@ -30,9 +31,18 @@ private:
     Sampler sampler;
     std::vector<double> propensities;
     int number_of_active_indices;
-    double propensity_sum;
+    CompensatedSum propensity_sum;
     unsigned long int last_non_zero_event;
 
+    // the running propensity sum is replaced by a fresh sum of the
+    // propensities once resync_interval updates have been made.
+    // drift accumulates the corrections made at each resync.
+    unsigned long int resync_interval;
+    unsigned long int updates_since_resync;
+    double drift;
+
+    void resync();
+
 public:
     // for linear solver we can moves initial_propensities vector into the object
     // and use it as the propensity buffer. For compatibility with other solvers,
@@ -41,10 +51,16 @@ public:
     LinearSolver(unsigned long int seed, std::vector<double> &initial_propensities);
     LinearSolver() : sampler(Sampler(0)){}; 
     void update(Update update);
-    void update(std::vector<Update> updates);
+    void update(const std::vector<Update> &updates);
     std::optional<Event> event();
     double get_propensity(int index);
     double get_propensity_sum();
+
+    static constexpr unsigned long int default_resync_interval = 1 << 20;
+    void set_resync_interval(unsigned long int interval);
+
+    // total absolute correction made to the running propensity sum
+    double get_drift();
 };
 
 #endif
\ No newline at end of file
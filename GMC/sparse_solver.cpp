@@ -41,7 +41,7 @@ void SparseSolver::update(Update update)
 
 /*---------------------------------------------------------------------------*/
 
-void SparseSolver::update(std::vector<Update> updates)
+void SparseSolver::update(const std::vector<Update> &updates)
 {
     for (Update update : updates)
         this->update(update);
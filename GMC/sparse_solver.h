@@ -27,7 +27,7 @@ public:
     SparseSolver(unsigned long int seed, std::vector<double> &initial_propensities);
     SparseSolver() : sampler(Sampler(0)){};
     void update(Update update);
-    void update(std::vector<Update> updates);
+    void update(const std::vector<Update> &updates);
     std::optional<Event> event();
     double get_propensity(int index);
     double get_propensity_sum();
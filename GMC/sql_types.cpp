@@ -5,6 +5,8 @@ https://blaugroup.github.io/RNMC/
 See the README file in the top-level RNMC directory.
 ---------------------------------------------------------------------- */
 
+#include <cstddef>
+
 #include "sql_types.h"
 
 /* -------------------------------- Reaction --------------------------------*/
@@ -48,16 +50,21 @@ void EnergyReactionSql::action(EnergyReactionSql &r, sqlite3_stmt *stmt)
 /* ----------------------------- Write Trajectory -----------------------------*/
 
 std::string ReactionNetworkWriteTrajectoriesSql::sql_statement =
-    "INSERT INTO trajectories VALUES (?1, ?2, ?3, ?4);";
+    "INSERT OR IGNORE INTO trajectories VALUES (?1, ?2, ?3, ?4);";
 
-void ReactionNetworkWriteTrajectoriesSql::action(ReactionNetworkWriteTrajectoriesSql &t, sqlite3_stmt *stmt)
+void ReactionNetworkWriteTrajectoriesSql::action(ReactionNetworkWriteTrajectoriesSql &t, sqlite3_stmt *stmt, int first_parameter)
 {
-    sqlite3_bind_int(stmt, 1, t.seed);
-    sqlite3_bind_int(stmt, 2, t.step);
-    sqlite3_bind_int(stmt, 3, t.reaction_id);
-    sqlite3_bind_double(stmt, 4, t.time);
+    sqlite3_bind_int(stmt, first_parameter, t.seed);
+    sqlite3_bind_int(stmt, first_parameter + 1, t.step);
+    sqlite3_bind_int(stmt, first_parameter + 2, t.reaction_id);
+    sqlite3_bind_double(stmt, first_parameter + 3, t.time);
 };
 
+std::vector<TrajectoryColumn> ReactionNetworkWriteTrajectoriesSql::trajectory_columns = {
+    {.name = "step", .type = column_int32, .offset = offsetof(ReactionNetworkWriteTrajectoriesSql, step)},
+    {.name = "reaction_id", .type = column_int32, .offset = offsetof(ReactionNetworkWriteTrajectoriesSql, reaction_id)},
+    {.name = "time", .type = column_float64, .offset = offsetof(ReactionNetworkWriteTrajectoriesSql, time)}};
+
 /* ----------------------------- Read Trajectory -----------------------------*/
 
 std::string ReactionNetworkReadTrajectoriesSql::sql_statement =
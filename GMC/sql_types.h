@@ -10,6 +10,9 @@ See the README file in the top-level RNMC directory.
 
 #include <sqlite3.h>
 #include <string>
+#include <vector>
+
+#include "../core/trajectory_file.h"
 
 class ReactionSql
 {
@@ -52,7 +55,8 @@ public:
     int reaction_id;
     double time;
     static std::string sql_statement;
-    static void action(ReactionNetworkWriteTrajectoriesSql &r, sqlite3_stmt *stmt);
+    static void action(ReactionNetworkWriteTrajectoriesSql &r, sqlite3_stmt *stmt, int first_parameter = 1);
+    static std::vector<TrajectoryColumn> trajectory_columns; // seed is stored per chunk
 };
 
 class ReactionNetworkReadTrajectoriesSql
@@ -74,10 +74,39 @@ void TreeSolver::update(Update update)
 
 /*---------------------------------------------------------------------------*/
 
-void TreeSolver::update(std::vector<Update> updates)
+void TreeSolver::update(const std::vector<Update> &updates)
 {
+    // write all the leaves first and remember which ones changed
+    dirty_nodes.clear();
     for (Update u : updates)
-        update(u);
+    {
+        int i = propensity_offset + u.index;
+        if (tree[i] > 0.0)
+            number_of_active_indices--;
+        if (u.propensity > 0.0)
+            number_of_active_indices++;
+        tree[i] = u.propensity;
+        dirty_nodes.push_back(i);
+    }
+
+    // then recompute each dirty ancestor once, one level at a time.
+    // all the leaves sit on the same level and taking parents preserves
+    // the order, so the dirty nodes only need to be sorted once.
+    std::sort(dirty_nodes.begin(), dirty_nodes.end());
+    dirty_nodes.erase(std::unique(dirty_nodes.begin(), dirty_nodes.end()),
+                      dirty_nodes.end());
+
+    while (!dirty_nodes.empty() && dirty_nodes[0] > 0)
+    {
+        for (int &i : dirty_nodes)
+            i = (i - 1) / 2;
+
+        dirty_nodes.erase(std::unique(dirty_nodes.begin(), dirty_nodes.end()),
+                          dirty_nodes.end());
+
+        for (int parent : dirty_nodes)
+            tree[parent] = tree[2 * parent + 1] + tree[2 * parent + 2];
+    }
 } // update()
 
 /*---------------------------------------------------------------------------*/
@@ -22,7 +22,9 @@ void print_usage()
               << "--thread_count\n"
               << "--step_cutoff|time_cutoff\n"
               << "--checkpoint\n"
-              << "--parameters\n";
+              << "--parameters\n"
+              << "--synchronous (optional: normal|off, sqlite sync mode during the run)\n"
+              << "--trajectory_file (optional: write trajectories to this binary file instead of the database)\n";
 
 } // print_usage()
 
@@ -47,7 +49,7 @@ void print_usage_LGMC_parameters()
 int main(int argc, char **argv)
 {
 
-    if (argc != 9)
+    if (argc < 9 || argc > 11)
     {
         print_usage();
         exit(EXIT_FAILURE);
@@ -63,6 +65,8 @@ int main(int argc, char **argv)
         {"time_cutoff", optional_argument, NULL, 7},
         {"checkpoint", required_argument, NULL, 8},
         {"parameters", required_argument, NULL, 9},
+        {"synchronous", required_argument, NULL, 10},
+        {"trajectory_file", required_argument, NULL, 11},
         {NULL, 0, NULL, 0}
         // last element of options array needs to be filled with zeros
     };
@@ -77,6 +81,8 @@ int main(int argc, char **argv)
     int thread_count = 0;
     char *LGMC_params_file = nullptr;
     bool isCheckpoint;
+    std::string synchronous = "normal";
+    std::string trajectory_file = "";
 
     Cutoff cutoff = {
         .bound = {.step = 0},
@@ -129,6 +135,14 @@ int main(int argc, char **argv)
             LGMC_params_file = optarg;
             break;
 
+        case 10:
+            synchronous = optarg;
+            break;
+
+        case 11:
+            trajectory_file = optarg;
+            break;
+
         default:
             // if an unexpected argument is passed, exit
             print_usage();
@@ -137,6 +151,18 @@ int main(int argc, char **argv)
         }
     }
 
+    if (synchronous != "normal" && synchronous != "off")
+    {
+        std::cout << "Unknown synchronous mode: " << synchronous << "\n";
+        print_usage();
+        exit(EXIT_FAILURE);
+    }
+
+    SqlWriteProfile write_profile{
+        .synchronous = synchronous == "off" ? "OFF" : "NORMAL",
+        .cache_size_mib = default_cache_size_mib,
+        .mmap_size_mib = default_mmap_size_mib};
+
     // read in LGMC parameters from file
     std::string LGMC_params_str(LGMC_params_file);
     std::ifstream fin;
@@ -219,7 +245,9 @@ int main(int argc, char **argv)
             base_seed,
             thread_count,
             cutoff,
-            parameters);
+            parameters,
+            write_profile,
+            trajectory_file);
 
     dispatcher.run_dispatcher();
     exit(EXIT_SUCCESS);
@@ -0,0 +1,321 @@
+/* ----------------------------------------------------------------------
+RNMC - Reaction Network Monte Carlo
+https://blaugroup.github.io/RNMC/
+
+See the README file in the top-level RNMC directory.
+---------------------------------------------------------------------- */
+
+#include <algorithm>
+#include <utility>
+
+#include "lattice_propensity_table.h"
+
+LatticeSumTree::LatticeSumTree() : tree(1, 0.0),
+                                   number_of_slots(1),
+                                   number_of_indices(0),
+                                   is_dirty(1, 0)
+{
+} // LatticeSumTree()
+
+/* ---------------------------------------------------------------------- */
+
+void LatticeSumTree::grow(unsigned long int index)
+{
+    unsigned long int old_number_of_slots = number_of_slots;
+    while (number_of_slots <= index)
+    {
+        number_of_slots *= 2;
+    }
+
+    std::vector<double> old_tree = std::move(tree);
+    tree.assign(2 * number_of_slots - 1, 0.0);
+
+    for (unsigned long int i = 0; i < number_of_indices; i++)
+    {
+        tree[number_of_slots - 1 + i] = old_tree[old_number_of_slots - 1 + i];
+    }
+
+    // the whole tree is rebuilt so nothing is left dirty
+    for (long int parent = number_of_slots - 2; parent >= 0; parent--)
+    {
+        tree[parent] = tree[2 * parent + 1] + tree[2 * parent + 2];
+    }
+
+    dirty_nodes.clear();
+    is_dirty.assign(number_of_slots, 0);
+} // grow()
+
+/* ---------------------------------------------------------------------- */
+
+void LatticeSumTree::set(unsigned long int index, double value)
+{
+    if (index >= number_of_slots)
+        grow(index);
+    if (index >= number_of_indices)
+        number_of_indices = index + 1;
+
+    tree[number_of_slots - 1 + index] = value;
+
+    if (!is_dirty[index])
+    {
+        is_dirty[index] = 1;
+        dirty_nodes.push_back(number_of_slots - 1 + index);
+    }
+} // set()
+
+/* ---------------------------------------------------------------------- */
+
+void LatticeSumTree::flush()
+{
+    if (dirty_nodes.empty())
+        return;
+
+    for (unsigned long int node : dirty_nodes)
+        is_dirty[node - (number_of_slots - 1)] = 0;
+
+    // when a large part of the leaves changed, for instance after the
+    // adsorption propensities of every site were recomputed, a linear
+    // rebuild is cheaper than sorting and walking up from each leaf
+    if (dirty_nodes.size() * 16 > number_of_slots)
+    {
+        for (long int parent = number_of_slots - 2; parent >= 0; parent--)
+        {
+            tree[parent] = tree[2 * parent + 1] + tree[2 * parent + 2];
+        }
+        dirty_nodes.clear();
+        return;
+    }
+
+    // all the leaves are on the same level, so mapping every node to its
+    // parent keeps them on the same level and sorted. recompute each
+    // dirty ancestor once, one level at a time.
+    std::sort(dirty_nodes.begin(), dirty_nodes.end());
+
+    while (dirty_nodes[0] > 0)
+    {
+        for (unsigned long int &node : dirty_nodes)
+        {
+            node = (node - 1) / 2;
+            tree[node] = tree[2 * node + 1] + tree[2 * node + 2];
+        }
+
+        dirty_nodes.erase(std::unique(dirty_nodes.begin(), dirty_nodes.end()),
+                          dirty_nodes.end());
+    }
+
+    dirty_nodes.clear();
+} // flush()
+
+/* ---------------------------------------------------------------------- */
+
+double LatticeSumTree::get(unsigned long int index)
+{
+    return tree[number_of_slots - 1 + index];
+} // get()
+
+/* ---------------------------------------------------------------------- */
+
+double LatticeSumTree::sum()
+{
+    flush();
+    return tree[0];
+} // sum()
+
+/* ---------------------------------------------------------------------- */
+
+unsigned long int LatticeSumTree::find(double &value)
+{
+    flush();
+
+    unsigned long int i = 0;
+    while (i < number_of_slots - 1)
+    {
+        unsigned long int left_child = 2 * i + 1;
+
+        // never step into an empty subtree, rounding error can leave
+        // value slightly above the sum of the left child
+        if (value < tree[left_child] || !(tree[left_child + 1] > 0.0))
+            i = left_child;
+        else
+        {
+            value -= tree[left_child];
+            i = left_child + 1;
+        }
+    }
+
+    return i - (number_of_slots - 1);
+} // find()
+
+/* ---------------------------------------------------------------------- */
+
+// number of slots the table starts with, must be a power of 2
+constexpr unsigned int initial_log_slots = 10;
+
+LatticePropensityTable::LatticePropensityTable() : keys(1 << initial_log_slots, 0),
+                                                   slots(1 << initial_log_slots, -1),
+                                                   shift(64 - initial_log_slots)
+{
+} // LatticePropensityTable()
+
+/* ---------------------------------------------------------------------- */
+
+uint64_t LatticePropensityTable::make_key(int site_one, int site_two)
+{
+    // the key does not depend on the order of the sites
+    if (site_one < site_two)
+        std::swap(site_one, site_two);
+
+    return (static_cast<uint64_t>(static_cast<uint32_t>(site_one)) << 32) |
+           static_cast<uint64_t>(static_cast<uint32_t>(site_two));
+} // make_key()
+
+/* ---------------------------------------------------------------------- */
+
+unsigned long int LatticePropensityTable::hash(uint64_t key)
+{
+    // fibonacci hashing, the top bits of the product are well mixed
+    return (key * 11400714819323198485ull) >> shift;
+} // hash()
+
+/* ---------------------------------------------------------------------- */
+
+int LatticePropensityTable::find(int site_one, int site_two)
+{
+    uint64_t key = make_key(site_one, site_two);
+    unsigned long int mask = slots.size() - 1;
+
+    for (unsigned long int i = hash(key);; i = (i + 1) & mask)
+    {
+        if (slots[i] < 0)
+            return -1;
+        if (keys[i] == key)
+            return slots[i];
+    }
+} // find()
+
+/* ---------------------------------------------------------------------- */
+
+int LatticePropensityTable::find_or_insert(int site_one, int site_two)
+{
+    uint64_t key = make_key(site_one, site_two);
+    unsigned long int mask = slots.size() - 1;
+
+    unsigned long int i = hash(key);
+    for (;; i = (i + 1) & mask)
+    {
+        if (slots[i] < 0)
+            break;
+        if (keys[i] == key)
+            return slots[i];
+    }
+
+    int bucket = buckets.size();
+    buckets.push_back(LatticePropensityBucket{
+        .site_one = std::max(site_one, site_two),
+        .site_two = std::min(site_one, site_two),
+        .reactions = {}});
+
+    keys[i] = key;
+    slots[i] = bucket;
+    is_dirty.push_back(0);
+    bucket_sums.set(bucket, 0.0);
+
+    // keep the load factor below 1/2 so probe sequences stay short
+    if (2 * buckets.size() > slots.size())
+        grow();
+
+    return bucket;
+} // find_or_insert()
+
+/* ---------------------------------------------------------------------- */
+
+void LatticePropensityTable::grow()
+{
+    std::vector<uint64_t> old_keys = std::move(keys);
+    std::vector<int> old_slots = std::move(slots);
+
+    keys.assign(2 * old_keys.size(), 0);
+    slots.assign(2 * old_slots.size(), -1);
+    shift--;
+
+    unsigned long int mask = slots.size() - 1;
+    for (unsigned long int j = 0; j < old_slots.size(); j++)
+    {
+        if (old_slots[j] < 0)
+            continue;
+
+        unsigned long int i = hash(old_keys[j]);
+        while (slots[i] >= 0)
+            i = (i + 1) & mask;
+
+        keys[i] = old_keys[j];
+        slots[i] = old_slots[j];
+    }
+} // grow()
+
+/* ---------------------------------------------------------------------- */
+
+double LatticePropensityTable::sum_bucket(int bucket)
+{
+    double sum = 0;
+    for (auto it = buckets[bucket].reactions.begin(); it != buckets[bucket].reactions.end(); it++)
+    {
+        sum += it->first;
+    }
+    return sum;
+} // sum_bucket()
+
+/* ---------------------------------------------------------------------- */
+
+void LatticePropensityTable::mark_dirty(int bucket)
+{
+    if (!is_dirty[bucket])
+    {
+        is_dirty[bucket] = 1;
+        dirty_buckets.push_back(bucket);
+    }
+} // mark_dirty()
+
+/* ---------------------------------------------------------------------- */
+
+void LatticePropensityTable::update_bucket_sums()
+{
+    for (int bucket : dirty_buckets)
+    {
+        is_dirty[bucket] = 0;
+        bucket_sums.set(bucket, sum_bucket(bucket));
+    }
+    dirty_buckets.clear();
+} // update_bucket_sums()
+
+/* ---------------------------------------------------------------------- */
+
+void LatticePropensityTable::add(int bucket, double propensity, int reaction_id)
+{
+    buckets[bucket].reactions.push_back(std::make_pair(propensity, reaction_id));
+    mark_dirty(bucket);
+} // add()
+
+/* ---------------------------------------------------------------------- */
+
+void LatticePropensityTable::clear_bucket(int bucket)
+{
+    buckets[bucket].reactions.clear();
+    mark_dirty(bucket);
+} // clear_bucket()
+
+/* ---------------------------------------------------------------------- */
+
+double LatticePropensityTable::get_propensity_sum()
+{
+    update_bucket_sums();
+    return bucket_sums.sum();
+} // get_propensity_sum()
+
+/* ---------------------------------------------------------------------- */
+
+int LatticePropensityTable::find_bucket(double &value)
+{
+    update_bucket_sums();
+    return bucket_sums.find(value);
+} // find_bucket()
@@ -0,0 +1,111 @@
+/* ----------------------------------------------------------------------
+RNMC - Reaction Network Monte Carlo
+https://blaugroup.github.io/RNMC/
+
+See the README file in the top-level RNMC directory.
+---------------------------------------------------------------------- */
+
+#ifndef RNMC_LATTICE_PROPENSITY_TABLE_H
+#define RNMC_LATTICE_PROPENSITY_TABLE_H
+
+#include <vector>
+#include <cstdint>
+
+// binary tree of partial sums over a growable array of values, used to
+// select an index with probability proportional to its value in
+// O(log N). set() only writes the leaf, the ancestors of every leaf set
+// since the last query are recomputed from their children once when the
+// tree is next queried, so a step touching the same index many times
+// pays for a single walk to the root and the sums do not accumulate
+// rounding error.
+class LatticeSumTree
+{
+public:
+    LatticeSumTree();
+
+    void set(unsigned long int index, double value);
+    double get(unsigned long int index);
+    double sum();
+
+    // walk from the root to the leaf where the partial sum first
+    // exceeds value. value is left holding the remainder within that
+    // leaf. a leaf with a zero value is only returned if all are zero.
+    unsigned long int find(double &value);
+
+private:
+    std::vector<double> tree;            // we store the values in a binary heap
+    unsigned long int number_of_slots;   // number of leaves, a power of 2
+    unsigned long int number_of_indices; // one past the largest index set
+    std::vector<unsigned long int> dirty_nodes; // leaves set since the last query
+    std::vector<char> is_dirty;                 // per leaf, avoids duplicates in dirty_nodes
+
+    void grow(unsigned long int index);
+
+    // recompute the ancestors of the dirty leaves
+    void flush();
+};
+
+// all the lattice reactions which can occur between a pair of sites.
+// site_two is one of SITE_HOMOGENEOUS or SITE_SELF_REACTION for
+// reactions involving a single lattice site. site_one > site_two.
+struct LatticePropensityBucket
+{
+    int site_one;
+    int site_two;
+    std::vector<std::pair<double, int>> reactions; // (propensity, reaction id)
+};
+
+// lattice propensities keyed by site pair. the (unordered) pair of
+// sites is packed into a 64 bit key and looked up in an open addressing
+// table with linear probing which maps it to a bucket index. buckets are
+// stored contiguously in order of creation and are never removed, a
+// cleared bucket keeps its storage for the next time the pair becomes
+// active, so once every pair has been seen a step does not allocate.
+// the sum of each bucket is kept in a LatticeSumTree, so buckets must
+// only be modified through add() and clear_bucket(). these only mark the
+// bucket as changed, its sum is recomputed once before the tree is next
+// queried.
+
+class LatticePropensityTable
+{
+public:
+    std::vector<LatticePropensityBucket> buckets;
+
+    LatticePropensityTable();
+
+    // bucket index of a site pair, -1 if the pair has no bucket yet
+    int find(int site_one, int site_two);
+
+    // bucket index of a site pair, creating an empty bucket if needed
+    int find_or_insert(int site_one, int site_two);
+
+    double sum_bucket(int bucket);
+
+    void add(int bucket, double propensity, int reaction_id);
+    void clear_bucket(int bucket);
+
+    // sum of the propensities of all buckets
+    double get_propensity_sum();
+
+    // find the bucket where the partial sum over buckets first exceeds
+    // value. value is left holding the remainder within the bucket.
+    int find_bucket(double &value);
+
+private:
+    std::vector<uint64_t> keys;
+    std::vector<int> slots; // bucket index for each key, -1 if unused
+    unsigned int shift;     // 64 - log2(number of slots)
+    LatticeSumTree bucket_sums;
+    std::vector<int> dirty_buckets; // buckets changed since the last query
+    std::vector<char> is_dirty;     // per bucket, avoids duplicates in dirty_buckets
+
+    static uint64_t make_key(int site_one, int site_two);
+    unsigned long int hash(uint64_t key);
+    void grow();
+    void mark_dirty(int bucket);
+
+    // write the sums of the changed buckets into bucket_sums
+    void update_bucket_sums();
+};
+
+#endif
@@ -60,8 +60,7 @@ LatticeReactionNetwork::LatticeReactionNetwork(SqlConnection
 /* ---------------------------------------------------------------------- */
 
 void LatticeReactionNetwork::update_state(std::unique_ptr<Lattice> &lattice,
-                                          std::unordered_map<std::string,
-                                                             std::vector<std::pair<double, int>>> &props,
+                                          LatticePropensityTable &props,
                                           std::vector<int> &state, int next_reaction,
                                           std::optional<int> site_one,
                                           std::optional<int> site_two, long double &prop_sum,
@@ -94,45 +93,39 @@ void LatticeReactionNetwork::update_state(std::unique_ptr<Lattice> &lattice,
 
 void LatticeReactionNetwork::update_propensities(std::unique_ptr<Lattice> &lattice,
                                                  std::vector<int> &state,
-                                                 std::function<void(Update update)> update_function,
-                                                 std::function<void(LatticeUpdate lattice_update,
-                                                                    std::unordered_map<std::string,
-                                                                                       std::vector<std::pair<double, int>>> &props)>
-                                                     lattice_update_function,
+                                                 LatticeSolver &solver,
                                                  int next_reaction,
                                                  std::optional<int> site_one, std::optional<int> site_two,
-                                                 std::unordered_map<std::string,
-                                                                    std::vector<std::pair<double, int>>> &props)
+                                                 LatticePropensityTable &props)
 {
 
     if (site_one)
     {
         // update lattice state
         bool update_gillepsie = update_propensities(lattice,
-                                                    lattice_update_function, next_reaction,
+                                                    solver, next_reaction,
                                                     site_one.value(), site_two.value(), props);
 
         if (update_gillepsie)
         {
-            update_propensities(update_function, state, next_reaction, lattice);
+            update_propensities(solver, state, next_reaction, lattice);
         }
     }
 
     else
     {
         // homoegenous event happens
-        update_propensities(update_function, state, next_reaction, lattice);
+        update_propensities(solver, state, next_reaction, lattice);
     }
 
-    update_adsorp_props(lattice, lattice_update_function, state, props);
+    update_adsorp_props(lattice, solver, state, props);
 
 } // update_propensities()
 
 /* ---------------------------------------------------------------------- */
 
 void LatticeReactionNetwork::update_adsorp_state(std::unique_ptr<Lattice> &lattice,
-                                                 std::unordered_map<std::string,
-                                                                    std::vector<std::pair<double, int>>> &props,
+                                                 LatticePropensityTable &props,
                                                  long double &prop_sum, int &active_indices)
 {
 
@@ -151,13 +144,9 @@ void LatticeReactionNetwork::update_adsorp_state(std::unique_ptr<Lattice> &latti
 /* ---------------------------------------------------------------------- */
 
 void LatticeReactionNetwork::update_adsorp_props(std::unique_ptr<Lattice> &lattice,
-                                                 std::function<void(LatticeUpdate lattice_update,
-                                                                    std::unordered_map<std::string,
-                                                                                       std::vector<std::pair<double, int>>> &props)>
-                                                     lattice_update_function,
+                                                 LatticeSolver &solver,
                                                  std::vector<int> &state,
-                                                 std::unordered_map<std::string,
-                                                                    std::vector<std::pair<double, int>>> &props)
+                                                 LatticePropensityTable &props)
 {
 
     // update only sites on the edge
@@ -188,12 +177,12 @@ void LatticeReactionNetwork::update_adsorp_props(std::unique_ptr<Lattice> &latti
 
                         double new_propensity = compute_propensity(1, state[reaction.reactants[other_reactant_id]], reaction_id, lattice);
 
-                        lattice_update_function(LatticeUpdate{
-                                                    .index = reaction_id,
-                                                    .propensity = new_propensity,
-                                                    .site_one = site,
-                                                    .site_two = SITE_HOMOGENEOUS},
-                                                props);
+                        solver.update(LatticeUpdate{
+                                          .index = reaction_id,
+                                          .propensity = new_propensity,
+                                          .site_one = site,
+                                          .site_two = SITE_HOMOGENEOUS},
+                                      props);
                     }
                 }
             }
@@ -258,8 +247,7 @@ double LatticeReactionNetwork::compute_propensity(int num_one, int num_two,
 /* ---------------------------------------------------------------------- */
 
 bool LatticeReactionNetwork::update_state_lattice(std::unique_ptr<Lattice> &lattice,
-                                                  std::unordered_map<std::string,
-                                                                     std::vector<std::pair<double, int>>> &props,
+                                                  LatticePropensityTable &props,
                                                   int next_reaction, int site_one, int site_two,
                                                   long double &prop_sum, int &active_indices,
                                                   bool &flip_sites)
@@ -520,13 +508,9 @@ bool LatticeReactionNetwork::update_state_lattice(std::unique_ptr<Lattice> &latt
 /* ---------------------------------------------------------------------- */
 
 bool LatticeReactionNetwork::update_propensities(std::unique_ptr<Lattice> &lattice,
-                                                 std::function<void(LatticeUpdate lattice_update,
-                                                                    std::unordered_map<std::string,
-                                                                                       std::vector<std::pair<double, int>>> &props)>
-                                                     update_function,
+                                                 LatticeSolver &solver,
                                                  int next_reaction, int site_one, int site_two,
-                                                 std::unordered_map<std::string,
-                                                                    std::vector<std::pair<double, int>>> &props)
+                                                 LatticePropensityTable &props)
 {
 
     LatticeReaction reaction = reactions[next_reaction];
@@ -538,7 +522,7 @@ bool LatticeReactionNetwork::update_propensities(std::unique_ptr<Lattice> &latti
         assert(lattice->sites[site_one].species == reaction.products[0]);
         assert(site_two == SITE_HOMOGENEOUS);
 
-        relevant_react(lattice, update_function, site_one, std::optional<int>(), props);
+        relevant_react(lattice, solver, site_one, std::optional<int>(), props);
 
         if (is_add_sites)
         {
@@ -548,7 +532,7 @@ bool LatticeReactionNetwork::update_propensities(std::unique_ptr<Lattice> &latti
                                                             lattice->sites[site_one].k + 1};
             int site_new = lattice->loc_map[key];
 
-            relevant_react(lattice, update_function, site_new, site_one, props);
+            relevant_react(lattice, solver, site_new, site_one, props);
         }
 
         return true;
@@ -563,7 +547,7 @@ bool LatticeReactionNetwork::update_propensities(std::unique_ptr<Lattice> &latti
             assert(lattice->sites[site_one].species == SPECIES_EMPTY);
             assert(site_two == SITE_HOMOGENEOUS);
 
-            relevant_react(lattice, update_function, site_one, std::optional<int>(), props);
+            relevant_react(lattice, solver, site_one, std::optional<int>(), props);
         }
         else if (is_add_sites)
         {
@@ -577,7 +561,7 @@ bool LatticeReactionNetwork::update_propensities(std::unique_ptr<Lattice> &latti
             {
                 int site_below = lattice->loc_map[key];
                 assert(lattice->sites.find(site_below) != lattice->sites.end());
-                relevant_react(lattice, update_function, site_below, std::optional<int>(), props);
+                relevant_react(lattice, solver, site_below, std::optional<int>(), props);
             }
         }
 
@@ -594,21 +578,21 @@ bool LatticeReactionNetwork::update_propensities(std::unique_ptr<Lattice> &latti
             assert(lattice->sites[site_one].species == reaction.products[0]);
             assert(site_two == SITE_SELF_REACTION);
 
-            relevant_react(lattice, update_function, site_one, std::optional<int>(), props);
+            relevant_react(lattice, solver, site_one, std::optional<int>(), props);
         }
         else
         {
             assert(lattice->sites.find(site_two) != lattice->sites.end());
-            relevant_react(lattice, update_function, site_one, site_two, props);
-            relevant_react(lattice, update_function, site_two, std::optional<int>(), props);
+            relevant_react(lattice, solver, site_one, site_two, props);
+            relevant_react(lattice, solver, site_two, std::optional<int>(), props);
         }
         return false;
     } // HOMOGENEOUS_SOLID
     else if (reaction.type == Type::DIFFUSION)
     {
 
-        relevant_react(lattice, update_function, site_one, site_two, props);
-        relevant_react(lattice, update_function, site_two, std::optional<int>(), props);
+        relevant_react(lattice, solver, site_one, site_two, props);
+        relevant_react(lattice, solver, site_two, std::optional<int>(), props);
 
         return false;
     } // DIFFUSION
@@ -621,8 +605,7 @@ bool LatticeReactionNetwork::update_propensities(std::unique_ptr<Lattice> &latti
 /* ---------------------------------------------------------------------- */
 
 void LatticeReactionNetwork::clear_site(std::unique_ptr<Lattice> &lattice,
-                                        std::unordered_map<std::string,
-                                                           std::vector<std::pair<double, int>>> &props,
+                                        LatticePropensityTable &props,
                                         int site, std::optional<int> ignore_neighbor,
                                         long double &prop_sum, int &active_indices)
 {
@@ -647,29 +630,28 @@ void LatticeReactionNetwork::clear_site(std::unique_ptr<Lattice> &lattice,
 /* ---------------------------------------------------------------------- */
 
 // deal with active_indices
-void LatticeReactionNetwork::clear_site_helper(std::unordered_map<std::string,
-                                                                  std::vector<std::pair<double, int>>> &props,
+void LatticeReactionNetwork::clear_site_helper(LatticePropensityTable &props,
                                                int site_one, int site_two, long double &prop_sum,
                                                int &active_indices)
 {
 
-    std::string combo = make_string(site_one, site_two);
+    int bucket = props.find(site_one, site_two);
 
     // check if first time key has been added
-    if (props.find(combo) == props.end())
+    if (bucket < 0)
     {
         // key not found
-        props[combo].reserve(reactions.size());
+        bucket = props.find_or_insert(site_one, site_two);
+        props.buckets[bucket].reactions.reserve(reactions.size());
     }
     else
     {
         // already exists, clear vector to update
-        std::vector<std::pair<double, int>> vec = props[combo];
-        prop_sum -= sum_row(combo, props);
+        prop_sum -= props.sum_bucket(bucket);
 
-        active_indices -= props[combo].size();
+        active_indices -= props.buckets[bucket].reactions.size();
 
-        props[combo].clear();
+        props.clear_bucket(bucket);
     }
 
 } // clear_site_helper
@@ -677,16 +659,14 @@ void LatticeReactionNetwork::clear_site_helper(std::unordered_map<std::string,
 /* ---------------------------------------------------------------------- */
 
 void LatticeReactionNetwork::relevant_react(std::unique_ptr<Lattice> &lattice,
-                                            std::function<void(LatticeUpdate lattice_update, std::unordered_map<std::string,
-                                                                                                                std::vector<std::pair<double, int>>> &props)>
-                                                update_function,
+                                            LatticeSolver &solver,
                                             int site, std::optional<int> ignore_neighbor,
-                                            std::unordered_map<std::string, std::vector<std::pair<double, int>>> &props)
+                                            LatticePropensityTable &props)
 {
 
     // all reactions related to central site
     assert(lattice->sites.find(site) != lattice->sites.end());
-    std::vector<int> potential_reactions = dependents[lattice->sites[site].species];
+    std::vector<int> &potential_reactions = dependents[lattice->sites[site].species];
 
     // compute and add new propensities
     for (size_t i = 0; i < potential_reactions.size(); i++)
@@ -710,12 +690,12 @@ void LatticeReactionNetwork::relevant_react(std::unique_ptr<Lattice> &lattice,
 
                     double new_propensity = compute_propensity(1, 0, reaction_id, lattice);
 
-                    update_function(LatticeUpdate{
-                                        .index = reaction_id,
-                                        .propensity = new_propensity,
-                                        .site_one = site,
-                                        .site_two = SITE_HOMOGENEOUS},
-                                    props);
+                    solver.update(LatticeUpdate{
+                                      .index = reaction_id,
+                                      .propensity = new_propensity,
+                                      .site_one = site,
+                                      .site_two = SITE_HOMOGENEOUS},
+                                  props);
                 }
             }
             else
@@ -723,12 +703,12 @@ void LatticeReactionNetwork::relevant_react(std::unique_ptr<Lattice> &lattice,
                 // oxidation / reduction / homogeneous solid with one reactant
                 double new_propensity = compute_propensity(1, 0, reaction_id, lattice, site);
 
-                update_function(LatticeUpdate{
-                                    .index = reaction_id,
-                                    .propensity = new_propensity,
-                                    .site_one = site,
-                                    .site_two = SITE_SELF_REACTION},
-                                props);
+                solver.update(LatticeUpdate{
+                                  .index = reaction_id,
+                                  .propensity = new_propensity,
+                                  .site_one = site,
+                                  .site_two = SITE_SELF_REACTION},
+                              props);
             }
 
         } // single reactant
@@ -766,12 +746,12 @@ void LatticeReactionNetwork::relevant_react(std::unique_ptr<Lattice> &lattice,
 
                             double new_propensity = compute_propensity(1, 1, reaction_id, lattice);
 
-                            update_function(LatticeUpdate{
-                                                .index = reaction_id,
-                                                .propensity = new_propensity,
-                                                .site_one = site,
-                                                .site_two = neighbor},
-                                            props);
+                            solver.update(LatticeUpdate{
+                                              .index = reaction_id,
+                                              .propensity = new_propensity,
+                                              .site_one = site,
+                                              .site_two = neighbor},
+                                          props);
                         }
                     } // ignore_neighbor
                 } // for neigh
@@ -782,15 +762,6 @@ void LatticeReactionNetwork::relevant_react(std::unique_ptr<Lattice> &lattice,
 
 /* ---------------------------------------------------------------------- */
 
-std::string LatticeReactionNetwork::make_string(int site_one, int site_two)
-{
-
-    return (site_one > site_two) ? std::to_string(site_one) + "." +
-                                       std::to_string(site_two)
-                                 : std::to_string(site_two) + "." + std::to_string(site_one);
-
-} // make_string
-
 std::string LatticeReactionNetwork::make_string(std::vector<int> vec)
 {
     std::sort(vec.begin(), vec.end());
@@ -807,20 +778,6 @@ std::string LatticeReactionNetwork::make_string(std::vector<int> vec)
 
 /* ---------------------------------------------------------------------- */
 
-double LatticeReactionNetwork::sum_row(std::string hash, std::unordered_map<std::string,
-                                                                            std::vector<std::pair<double, int>>> &props)
-{
-
-    double sum = 0;
-    for (auto it = props[hash].begin(); it != props[hash].end(); it++)
-    {
-        sum += it->first;
-    }
-    return sum;
-} // sum_row()
-
-/* ---------------------------------------------------------------------- */
-
 void LatticeReactionNetwork::init_reaction_network(SqlConnection &reaction_network_database,
                                                    SqlConnection &initial_state_database,
                                                    LatticeParameters parameters)
@@ -1063,7 +1020,7 @@ void LatticeReactionNetwork::update_state_solution(std::vector<int> &state,
 
 /* ---------------------------------------------------------------------- */
 
-void LatticeReactionNetwork::update_propensities(std::function<void(Update update)> update_function,
+void LatticeReactionNetwork::update_propensities(LatticeSolver &solver,
                                                  std::vector<int> &state, int next_reaction,
                                                  std::unique_ptr<Lattice> &lattice)
 {
@@ -1100,7 +1057,7 @@ void LatticeReactionNetwork::update_propensities(std::function<void(Update updat
 
             double new_propensity = compute_propensity(state, reaction_index, lattice);
 
-            update_function(Update{
+            solver.update(Update{
                 .index = reaction_index,
                 .propensity = new_propensity});
         }
@@ -1222,7 +1179,6 @@ void LatticeReactionNetwork::checkpoint(SqlReader<LatticeReadStateSql> state_rea
                                         SqlReader<LatticeReadTrajectoriesSql>,
                                         std::map<int, LatticeState> &temp_seed_state_map,
                                         std::map<int, int> &temp_seed_step_map,
-                                        SeedQueue &temp_seed_queue,
                                         std::map<int, double> &temp_seed_time_map,
                                         LatticeReactionNetwork &model)
 {
@@ -1255,18 +1211,23 @@ void LatticeReactionNetwork::checkpoint(SqlReader<LatticeReadStateSql> state_rea
     {
         int initial_latconst = model.initial_state.lattice->latconst;
 
-        // create a default lattice for each simulation
-        while (std::optional<unsigned long int> maybe_seed =
-                   temp_seed_queue.get_seed())
+        // only seeds with a checkpoint get an entry, starting from an
+        // empty lattice which the sites in interrupt_state are added to.
+        // the other seeds copy initial_state when they run.
+        auto seed_state = [&](int seed) -> LatticeState &
         {
-            unsigned long int seed = maybe_seed.value();
-
-            // Each LatticeState must have its own lattice to point to
-            std::unique_ptr<Lattice> default_lattice(new Lattice(initial_latconst));
+            auto it = temp_seed_state_map.find(seed);
+            if (it == temp_seed_state_map.end())
+            {
+                // Each LatticeState must have its own lattice to point to
+                std::unique_ptr<Lattice> default_lattice(new Lattice(initial_latconst));
 
-            LatticeState default_state = {model.initial_state.homogeneous, std::move(default_lattice)};
-            temp_seed_state_map.insert(std::make_pair(seed, std::move(default_state)));
-        }
+                it = temp_seed_state_map.emplace(seed, LatticeState(model.initial_state.homogeneous,
+                                                                    std::move(default_lattice)))
+                         .first;
+            }
+            return it->second;
+        };
 
         // go through interrupt_state and add each site one by one or update homogeneous region
         while (std::optional<LatticeReadStateSql> maybe_state_row = state_reader.next())
@@ -1277,7 +1238,7 @@ void LatticeReactionNetwork::checkpoint(SqlReader<LatticeReadStateSql> state_rea
             if (state_row.site_mapping == SITE_HOMOGENEOUS)
             {
                 // set the quantity of the homogeneous region vector associated with that seed
-                temp_seed_state_map[state_row.seed].homogeneous[state_row.species_id] = state_row.quantity;
+                seed_state(state_row.seed).homogeneous[state_row.species_id] = state_row.quantity;
             }
             else
             {
@@ -1288,19 +1249,19 @@ void LatticeReactionNetwork::checkpoint(SqlReader<LatticeReadStateSql> state_rea
                 int k = std::get<2>(seed_ijk_map[state_row.seed][state_row.site_mapping]);
 
                 // add site
-                temp_seed_state_map[state_row.seed].lattice->add_site(i, j, k,
+                seed_state(state_row.seed).lattice->add_site(i, j, k,
                                                                       can_adsorb, true, false);
 
                 // update site occupancy
                 std::tuple<uint32_t, uint32_t, uint32_t> key = {i, j, k};
-                int site_id = temp_seed_state_map[state_row.seed].lattice->loc_map[key];
-                assert(temp_seed_state_map[state_row.seed].lattice->sites.find(site_id) != temp_seed_state_map[state_row.seed].lattice->sites.end());
-                temp_seed_state_map[state_row.seed].lattice->sites[site_id].species = state_row.species_id;
+                int site_id = seed_state(state_row.seed).lattice->loc_map[key];
+                assert(seed_state(state_row.seed).lattice->sites.find(site_id) != seed_state(state_row.seed).lattice->sites.end());
+                seed_state(state_row.seed).lattice->sites[site_id].species = state_row.species_id;
 
                 // if can adsorb, check if species occupies the site
-                if (temp_seed_state_map[state_row.seed].lattice->sites[site_id].can_adsorb && state_row.species_id != SPECIES_EMPTY)
+                if (seed_state(state_row.seed).lattice->sites[site_id].can_adsorb && state_row.species_id != SPECIES_EMPTY)
                 {
-                    temp_seed_state_map[state_row.seed].lattice->edges[site_id] = 'd';
+                    seed_state(state_row.seed).lattice->edges[site_id] = 'd';
                 }
             }
         }
@@ -1310,22 +1271,25 @@ void LatticeReactionNetwork::checkpoint(SqlReader<LatticeReadStateSql> state_rea
         // static lattice or dynamic and not reading from state
         int initial_latconst = model.initial_state.lattice->latconst;
 
-        // create a default lattice for each simulation
-        while (std::optional<unsigned long int> maybe_seed =
-                   temp_seed_queue.get_seed())
+        // only seeds with a checkpoint get an entry, starting from a
+        // default lattice. the other seeds copy initial_state when they run.
+        auto seed_state = [&](int seed) -> LatticeState &
         {
-            unsigned long int seed = maybe_seed.value();
-
-            // Each LatticeState must have its own lattice to point to
-            std::unique_ptr<Lattice> default_lattice(new Lattice(initial_latconst,
-                                                                 model.initial_state.lattice->xhi / initial_latconst,
-                                                                 model.initial_state.lattice->yhi / initial_latconst,
-                                                                 model.initial_state.lattice->zhi / initial_latconst));
-
-            LatticeState default_state = {model.initial_state.homogeneous, std::move(default_lattice)};
-
-            temp_seed_state_map.insert(std::make_pair(seed, std::move(default_state)));
-        }
+            auto it = temp_seed_state_map.find(seed);
+            if (it == temp_seed_state_map.end())
+            {
+                // Each LatticeState must have its own lattice to point to
+                std::unique_ptr<Lattice> default_lattice(new Lattice(initial_latconst,
+                                                                     model.initial_state.lattice->xhi / initial_latconst,
+                                                                     model.initial_state.lattice->yhi / initial_latconst,
+                                                                     model.initial_state.lattice->zhi / initial_latconst));
+
+                it = temp_seed_state_map.emplace(seed, LatticeState(model.initial_state.homogeneous,
+                                                                    std::move(default_lattice)))
+                         .first;
+            }
+            return it->second;
+        };
 
         while (std::optional<LatticeReadStateSql> maybe_state_row = state_reader.next())
         {
@@ -1335,7 +1299,7 @@ void LatticeReactionNetwork::checkpoint(SqlReader<LatticeReadStateSql> state_rea
             if (state_row.site_mapping == SITE_HOMOGENEOUS)
             {
                 // set the quantity of the homogeneous region vector associated with that seed
-                temp_seed_state_map[state_row.seed].homogeneous[state_row.species_id] = state_row.quantity;
+                seed_state(state_row.seed).homogeneous[state_row.species_id] = state_row.quantity;
             }
             else
             {
@@ -1345,13 +1309,13 @@ void LatticeReactionNetwork::checkpoint(SqlReader<LatticeReadStateSql> state_rea
 
                 // update site occupancy
                 std::tuple<uint32_t, uint32_t, uint32_t> key = {i, j, k};
-                int site_id = temp_seed_state_map[state_row.seed].lattice->loc_map[key];
-                temp_seed_state_map[state_row.seed].lattice->sites[site_id].species = state_row.species_id;
+                int site_id = seed_state(state_row.seed).lattice->loc_map[key];
+                seed_state(state_row.seed).lattice->sites[site_id].species = state_row.species_id;
 
                 // if can adsorb, check if species occupies the site
-                if (temp_seed_state_map[state_row.seed].lattice->sites[site_id].can_adsorb && state_row.species_id != SPECIES_EMPTY)
+                if (seed_state(state_row.seed).lattice->sites[site_id].can_adsorb && state_row.species_id != SPECIES_EMPTY)
                 {
-                    temp_seed_state_map[state_row.seed].lattice->edges[site_id] = 'd';
+                    seed_state(state_row.seed).lattice->edges[site_id] = 'd';
                 }
             }
         }
@@ -1427,13 +1391,9 @@ void LatticeReactionNetwork::compute_initial_propensities(std::vector<int> state
 /* ---------------------------------------------------------------------- */
 
 void LatticeReactionNetwork::update_all_propensities(std::unique_ptr<Lattice> &lattice,
-                                                     std::unordered_map<std::string,
-                                                                        std::vector<std::pair<double, int>>> &props,
+                                                     LatticePropensityTable &props,
                                                      long double &prop_sum, int &active_indices,
-                                                     std::function<void(LatticeUpdate lattice_update,
-                                                                        std::unordered_map<std::string,
-                                                                        std::vector<std::pair<double, int>>> &props)>
-                                                         update_function)
+                                                     LatticeSolver &solver)
 {
 
     // Go through all lattice sites and update their propensities
@@ -1443,7 +1403,7 @@ void LatticeReactionNetwork::update_all_propensities(std::unique_ptr<Lattice> &l
         int site_id = lattice->loc_map[key];
 
         clear_site(lattice, props, site_id, std::optional<int>(), prop_sum, active_indices);
-        relevant_react(lattice, update_function, site_id, std::optional<int>(), props);
+        relevant_react(lattice, solver, site_id, std::optional<int>(), props);
     }
 } // update_all_propensities()
 
@@ -117,86 +117,60 @@ public:
 
     /* -------------------------------- Updates Global ----------------------------- */
 
-    void update_state(std::unique_ptr<Lattice> &lattice, std::unordered_map<std::string, 
-                      std::vector<std::pair<double, int>>> &props,
+    void update_state(std::unique_ptr<Lattice> &lattice, LatticePropensityTable &props,
                       std::vector<int> &state, int next_reaction,
                       std::optional<int> site_one, std::optional<int> site_two,
                       long double &prop_sum, int &active_indices, bool &flip_sites);
 
     void update_propensities(std::unique_ptr<Lattice> &lattice, std::vector<int> &state,
-                             std::function<void(Update update)> update_function,
-                             std::function<void(LatticeUpdate lattice_update, 
-                             std::unordered_map<std::string,
-                             std::vector<std::pair<double, int>>> &props)>
-                             lattice_update_function, int next_reaction, 
+                             LatticeSolver &solver, int next_reaction, 
                              std::optional<int> site_one, std::optional<int> site_two,
-                             std::unordered_map<std::string, std::vector<std::pair<double, int>>> &props);
+                             LatticePropensityTable &props);
 
     void update_adsorp_state(std::unique_ptr<Lattice> &lattice, 
-                             std::unordered_map<std::string, 
-                             std::vector<std::pair<double, int>>> &props,
+                             LatticePropensityTable &props,
                              long double &prop_sum, int &active_indices);
 
     void update_adsorp_props(std::unique_ptr<Lattice> &lattice, 
-                             std::function<void(LatticeUpdate lattice_update, 
-                             std::unordered_map<std::string, 
-                             std::vector<std::pair<double, int>>> &props)> lattice_update_function,
+                             LatticeSolver &solver,
                              std::vector<int> &state,
-                             std::unordered_map<std::string, std::vector<std::pair<double, int>>> &props);
+                             LatticePropensityTable &props);
 
     /* -------------------------------- Updates Lattice ----------------------------- */
 
     bool update_state_lattice(std::unique_ptr<Lattice> &lattice, 
-                              std::unordered_map<std::string, 
-                              std::vector<std::pair<double, int>>> &props,
+                              LatticePropensityTable &props,
                               int next_reaction, int site_one, int site_two,
                               long double &prop_sum, int &active_indices, bool &flip_sites);
 
     void clear_site(std::unique_ptr<Lattice> &lattice, 
-                    std::unordered_map<std::string, 
-                    std::vector<std::pair<double, int>>> &props,
+                    LatticePropensityTable &props,
                     int site, std::optional<int> ignore_neighbor,
                     long double &prop_sum, int &active_indices);
 
-    void clear_site_helper(std::unordered_map<std::string,
-                           std::vector<std::pair<double, int>>> &props,
+    void clear_site_helper(LatticePropensityTable &props,
                            int site_one, int site_two, long double &prop_sum,
                            int &active_indices);
 
     void relevant_react(std::unique_ptr<Lattice> &lattice, 
-                        std::function<void(LatticeUpdate lattice_update, 
-                        std::unordered_map<std::string, 
-                        std::vector<std::pair<double, int>>> &props)> update_function,
+                        LatticeSolver &solver,
                         int site, std::optional<int> ignore_neighbor,
-                        std::unordered_map<std::string, 
-                        std::vector<std::pair<double, int>>> &props);
+                        LatticePropensityTable &props);
 
     double compute_propensity(int num_one, int num_two, int react_id, 
                               std::unique_ptr<Lattice> &lattice, int site_id = 0);
 
     bool update_propensities(std::unique_ptr<Lattice> &lattice,
-                             std::function<void(LatticeUpdate lattice_update,
-                                                std::unordered_map<std::string,
-                                                std::vector<std::pair<double, int>>> &props)>
-                                                update_function,
+                             LatticeSolver &solver,
                              int next_reaction, int site_one, int site_two,
-                             std::unordered_map<std::string, 
-                             std::vector<std::pair<double, int>>> &props);
+                             LatticePropensityTable &props);
 
-    std::string make_string(int site_one, int site_two);
     std::string make_string(std::vector<int> vec);
 
-    double sum_row(std::string hash, std::unordered_map<std::string, 
-                   std::vector<std::pair<double, int>>> &props);
-
     void update_all_propensities(std::unique_ptr<Lattice> &lattice, 
-                                 std::unordered_map<std::string, 
-                                 std::vector<std::pair<double, int>>> &props,
+                                 LatticePropensityTable &props,
                                  long double &prop_sum, int &active_indices,
-                                 std::function<void(LatticeUpdate lattice_update,
-                                                    std::unordered_map<std::string,
-                                                    std::vector<std::pair<double, int>>> &props)>
-                                                    update_function);
+                                 LatticeSolver &solver);
 
     /* -------------------------- Updates Reaction Network ----------------------------- */
 
@@ -211,7 +185,7 @@ public:
     double compute_propensity(std::vector<int> &state, int reaction_index, 
                               std::unique_ptr<Lattice> &lattice);
 
-    void update_propensities(std::function<void(Update update)> update_function,
+    void update_propensities(LatticeSolver &solver,
                              std::vector<int> &state, int next_reaction, 
                              std::unique_ptr<Lattice> &lattice);
 
@@ -239,7 +213,6 @@ public:
                     SqlReader<LatticeReadTrajectoriesSql> trajectory_reader,
                     std::map<int, LatticeState> &temp_seed_state_map,
                     std::map<int, int> &temp_seed_step_map,
-                    SeedQueue &temp_seed_queue,
                     std::map<int, double> &temp_seed_time_map,
                     LatticeReactionNetwork &model);
 
@@ -17,11 +17,13 @@ LatticeSolver::LatticeSolver(unsigned long int seed,
                                                                            // propensities gets moved into a stack variable for the function
                                                                            // call and that stack variable is copied into the object.
                                                                            propensities(std::move(initial_propensities)),
-                                                                           sampler(Sampler(seed))
+                                                                           sampler(Sampler(seed)),
+                                                                           drift(0.0)
 {
     for (unsigned long i = 0; i < propensities.size(); i++)
     {
         propensity_sum += propensities[i];
+        propensity_tree.set(i, propensities[i]);
         if (propensities[i] > 0)
         {
             number_of_active_indices += 1;
@@ -35,11 +37,13 @@ LatticeSolver::LatticeSolver(unsigned long int seed,
                              std::vector<double> &initial_propensities) : propensity_sum(0.0),
                                                                           number_of_active_indices(0),
                                                                           propensities(initial_propensities),
-                                                                          sampler(Sampler(seed))
+                                                                          sampler(Sampler(seed)),
+                                                                          drift(0.0)
 {
     for (unsigned long i = 0; i < propensities.size(); i++)
     {
         propensity_sum += propensities[i];
+        propensity_tree.set(i, propensities[i]);
         if (propensities[i] > 0)
         {
             number_of_active_indices += 1;
@@ -64,26 +68,25 @@ void LatticeSolver::update(Update update)
     propensity_sum += update.propensity;
 
     propensities[update.index] = update.propensity;
+    propensity_tree.set(update.index, update.propensity);
 } // update()
 
 /* ---------------------------------------------------------------------- */
 
-void LatticeSolver::update(LatticeUpdate lattice_update, std::unordered_map<std::string,
-                                                                            std::vector<std::pair<double, int>>> &props)
+void LatticeSolver::update(LatticeUpdate lattice_update, LatticePropensityTable &props)
 {
 
     propensity_sum += lattice_update.propensity;
     number_of_active_indices++;
 
-    std::string hash = make_string(lattice_update.site_one, lattice_update.site_two);
-    props[hash].push_back(std::make_pair(lattice_update.propensity, lattice_update.index));
+    int bucket = props.find_or_insert(lattice_update.site_one, lattice_update.site_two);
+    props.add(bucket, lattice_update.propensity, lattice_update.index);
 } // update()
 
 /* ---------------------------------------------------------------------- */
 
 void LatticeSolver::update(std::vector<LatticeUpdate> lattice_updates,
-                           std::unordered_map<std::string,
-                                              std::vector<std::pair<double, int>>> &props)
+                           LatticePropensityTable &props)
 {
     for (LatticeUpdate u : lattice_updates)
     {
@@ -93,7 +96,7 @@ void LatticeSolver::update(std::vector<LatticeUpdate> lattice_updates,
 
 /* ---------------------------------------------------------------------- */
 
-void LatticeSolver::update(std::vector<Update> updates)
+void LatticeSolver::update(const std::vector<Update> &updates)
 {
     for (Update u : updates)
     {
@@ -103,136 +106,68 @@ void LatticeSolver::update(std::vector<Update> updates)
 
 /* ---------------------------------------------------------------------- */
 
-std::optional<LatticeEvent> LatticeSolver::event_lattice(std::unordered_map<std::string,
-                                                                            std::vector<std::pair<double, int>>> &props)
+std::optional<LatticeEvent> LatticeSolver::event_lattice(LatticePropensityTable &props)
 {
-    if (!(propensity_sum > 0))
-    {
-        double sum = 0;
-        for (int i = 0; i < int(propensities.size()); i++)
-        {
-            sum += propensities[i];
-        }
-        for (auto it = props.begin(); it != props.end(); it++)
-        {
-            for (int i = 0; i < int(it->second.size()); i++)
-            {
-                sum += it->second[i].first;
-            }
-        }
-        propensity_sum = sum;
+    double gillespie_sum = propensity_tree.sum();
+    double lattice_sum = props.get_propensity_sum();
 
-        if (!(propensity_sum > 0))
-        {
-            return std::optional<LatticeEvent>();
-        }
-    }
-    if (number_of_active_indices == 0)
+    // the sum trees are exact, so resynchronize the running total
+    drift += std::fabs(static_cast<double>(propensity_sum) - (gillespie_sum + lattice_sum));
+    propensity_sum = gillespie_sum + lattice_sum;
+
+    if (number_of_active_indices == 0 || !(propensity_sum > 0))
     {
         propensity_sum = 0.0;
         return std::optional<LatticeEvent>();
     }
 
-    bool isFound = false;
-    unsigned long m;
     unsigned long int reaction_id;
     std::optional<int> site_one;
     std::optional<int> site_two;
-    std::string hash;
-    double dt;
 
-    while (!isFound)
+    double r1 = sampler.generate();
+    double r2 = sampler.generate();
+    double fraction = propensity_sum * r1;
+
+    // start with Gillespie propensities
+    if (fraction < gillespie_sum || !(lattice_sum > 0))
     {
-        reaction_id = 0;
-        site_one = std::optional<int>();
-        site_two = std::optional<int>();
-        dt = 0.;
-
-        double r1 = sampler.generate();
-        double r2 = sampler.generate();
-        double fraction = propensity_sum * r1;
-        long double partial = 0.0;
-
-        // start with Gillespie propensities
-        for (m = 0; m < propensities.size(); m++)
+        reaction_id = propensity_tree.find(fraction);
+    }
+    // otherwise go through lattice propensities
+    else
+    {
+        double value = fraction - gillespie_sum;
+        int bucket = props.find_bucket(value);
+        std::vector<std::pair<double, int>> &reactions = props.buckets[bucket].reactions;
+
+        // rounding error can leave value past the end of the bucket,
+        // fall back to its last reaction in that case
+        reaction_id = reactions.back().second;
+        double partial = 0.0;
+        for (int i = 0; i < int(reactions.size()); i++)
         {
-            partial += propensities[m];
-            if (partial > fraction)
+            partial += reactions[i].first;
+            if (partial > value)
             {
-                isFound = true;
-                reaction_id = m;
+                reaction_id = reactions[i].second;
                 break;
             }
         }
 
-        // go through lattice propensities if not found
-        if (!isFound)
-        {
-            auto it = props.begin();
-            while (!isFound && it != props.end())
-            {
-                for (int i = 0; i < int(it->second.size()); i++)
-                {
-
-                    partial += it->second[i].first;
-
-                    if (partial > fraction)
-                    {
-
-                        isFound = true;
-                        hash = it->first;
-                        reaction_id = it->second[i].second;
-
-                        std::size_t pos = hash.find(".");
-                        site_one = std::optional<int>(stoi(hash.substr(0, pos)));
-                        site_two = std::optional<int>(stoi(hash.substr(pos + 1)));
-                        if (site_one < site_two)
-                        {
-                            assert(false);
-                        }
-                        isFound = true;
-                        break;
-                    }
-                }
-                it++;
-            }
-        }
-
-        dt = -std::log(r2) / propensity_sum;
-
-        // check if found, if not propensity sum is incorrect
-        if (!isFound || !(propensity_sum > 0))
-        {
-            double sum = 0;
-            for (int i = 0; i < static_cast<int>(propensities.size()); i++)
-            {
-                sum += propensities[i];
-            }
-            for (auto it = props.begin(); it != props.end(); it++)
-            {
-                for (int i = 0; i < int(it->second.size()); i++)
-                {
-                    sum += it->second[i].first;
-                }
-            }
-            propensity_sum = sum;
-
-            if (!(propensity_sum > 0))
-            {
-                return std::optional<LatticeEvent>();
-            }
-        }
+        site_one = std::optional<int>(props.buckets[bucket].site_one);
+        site_two = std::optional<int>(props.buckets[bucket].site_two);
+        assert(site_one > site_two);
     }
 
+    double dt = -std::log(r2) / propensity_sum;
+
     return std::optional<LatticeEvent>(LatticeEvent{.site_one = site_one, .site_two = site_two, .index = reaction_id, .dt = dt});
 } // event_lattice()
 
 /* ---------------------------------------------------------------------- */
 
-std::string LatticeSolver::make_string(int site_one, int site_two)
+double LatticeSolver::get_drift()
 {
-    return (site_one > site_two) ? std::to_string(site_one) + "." +
-                                       std::to_string(site_two)
-                                 : std::to_string(site_two) + "." + std::to_string(site_one);
-
-} // make_string()
+    return drift;
+} // get_drift()
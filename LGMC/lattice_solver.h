@@ -10,6 +10,7 @@ See the README file in the top-level RNMC directory.
 
 #include "../core/sampler.h"
 #include "../core/RNMC_types.h"
+#include "lattice_propensity_table.h"
 
 #include <vector>
 #include <unordered_map>
@@ -43,20 +44,25 @@ public:
     LatticeSolver(unsigned long int seed, std::vector<double> &initial_propensities);
 
     void update(Update update);
-    void update(std::vector<Update> updates);
+    void update(const std::vector<Update> &updates);
 
-    void update(LatticeUpdate lattice_update, std::unordered_map<std::string,
-                std::vector<std::pair<double, int>>> &props);
+    void update(LatticeUpdate lattice_update, LatticePropensityTable &props);
 
     void update(std::vector<LatticeUpdate> lattice_updates,
-                std::unordered_map<std::string,
-                std::vector<std::pair<double, int>>> &props);
+                LatticePropensityTable &props);
 
-    std::optional<LatticeEvent> event_lattice(std::unordered_map<std::string,
-                                              std::vector<std::pair<double, int>>> &props);
+    // events are selected in O(log N) by first choosing between the
+    // Gillespie and the lattice propensities, then walking the sum tree
+    // of either the Gillespie propensities or the buckets of props and
+    // finally scanning the reactions of the chosen bucket.
+    std::optional<LatticeEvent> event_lattice(LatticePropensityTable &props);
 
-    std::string make_string(int site_one, int site_two);
+    // total absolute correction made to propensity_sum when it is
+    // resynchronized with the sum trees
+    double get_drift();
 
+    // running sum kept up to date by the reaction network. it is
+    // replaced by the exact total of the sum trees on every event.
     long double propensity_sum;
     int number_of_active_indices; // end simulation of no sites with non zero propensity
 
@@ -64,6 +70,8 @@ public:
 
 private:
     Sampler sampler;
+    LatticeSumTree propensity_tree; // partial sums of the Gillespie propensities
+    double drift;
 };
 
 #endif
\ No newline at end of file
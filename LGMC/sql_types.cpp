@@ -5,6 +5,8 @@ https://blaugroup.github.io/RNMC/
 See the README file in the top-level RNMC directory.
 ---------------------------------------------------------------------- */
 
+#include <cstddef>
+
 #include "sql_types.h"
 
 /* -------------------------- LGMCReaction ----------------------------*/
@@ -55,18 +57,25 @@ void LatticeReadTrajectoriesSql::action(LatticeReadTrajectoriesSql &r, sqlite3_s
 /* ---------------------------------------------------------------------- */
 
 std::string LatticeWriteTrajectoriesSql::sql_statement =
-    "INSERT INTO trajectories VALUES (?1, ?2, ?3, ?4, ?5, ?6);";
+    "INSERT OR IGNORE INTO trajectories VALUES (?1, ?2, ?3, ?4, ?5, ?6);";
 
-void LatticeWriteTrajectoriesSql::action(LatticeWriteTrajectoriesSql &t, sqlite3_stmt *stmt)
+void LatticeWriteTrajectoriesSql::action(LatticeWriteTrajectoriesSql &t, sqlite3_stmt *stmt, int first_parameter)
 {
-    sqlite3_bind_int(stmt, 1, t.seed);
-    sqlite3_bind_int(stmt, 2, t.step);
-    sqlite3_bind_double(stmt, 3, t.time);
-    sqlite3_bind_int(stmt, 4, t.reaction_id);
-    sqlite3_bind_int(stmt, 5, t.site_1_mapping);
-    sqlite3_bind_int(stmt, 6, t.site_2_mapping);
+    sqlite3_bind_int(stmt, first_parameter, t.seed);
+    sqlite3_bind_int(stmt, first_parameter + 1, t.step);
+    sqlite3_bind_double(stmt, first_parameter + 2, t.time);
+    sqlite3_bind_int(stmt, first_parameter + 3, t.reaction_id);
+    sqlite3_bind_int(stmt, first_parameter + 4, t.site_1_mapping);
+    sqlite3_bind_int(stmt, first_parameter + 5, t.site_2_mapping);
 }
 
+std::vector<TrajectoryColumn> LatticeWriteTrajectoriesSql::trajectory_columns = {
+    {.name = "step", .type = column_int32, .offset = offsetof(LatticeWriteTrajectoriesSql, step)},
+    {.name = "time", .type = column_float64, .offset = offsetof(LatticeWriteTrajectoriesSql, time)},
+    {.name = "reaction_id", .type = column_int32, .offset = offsetof(LatticeWriteTrajectoriesSql, reaction_id)},
+    {.name = "site_1_mapping", .type = column_int32, .offset = offsetof(LatticeWriteTrajectoriesSql, site_1_mapping)},
+    {.name = "site_2_mapping", .type = column_int32, .offset = offsetof(LatticeWriteTrajectoriesSql, site_2_mapping)}};
+
 /* ---------------------------- LatticeStateSql -------------------------- */
 
 std::string LatticeReadStateSql::sql_statement =
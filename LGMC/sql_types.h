@@ -10,6 +10,9 @@ See the README file in the top-level RNMC directory.
 
 #include <sqlite3.h>
 #include <string>
+#include <vector>
+
+#include "../core/trajectory_file.h"
 
 class LGMCReactionSql
 {
@@ -68,7 +71,8 @@ public:
     int site_1_mapping;
     int site_2_mapping;
     static std::string sql_statement;
-    static void action(LatticeWriteTrajectoriesSql &r, sqlite3_stmt *stmt);
+    static void action(LatticeWriteTrajectoriesSql &r, sqlite3_stmt *stmt, int first_parameter = 1);
+    static std::vector<TrajectoryColumn> trajectory_columns; // seed is stored per chunk
 };
 
 /* --------- I/O State SQL ---------*/
@@ -20,7 +20,9 @@ void print_usage()
               << "--base_seed\n"
               << "--thread_count\n"
               << "--step_cutoff|time_cutoff\n"
-              << "--checkpoint\n";
+              << "--checkpoint\n"
+              << "--synchronous (optional: normal|off, sqlite sync mode during the run)\n"
+              << "--trajectory_file (optional: write trajectories to this binary file instead of the database)\n";
 
 } // print_usage()
 
@@ -28,7 +30,7 @@ void print_usage()
 
 int main(int argc, char **argv)
 {
-    if (argc != 8)
+    if (argc < 8 || argc > 10)
     {
         print_usage();
         exit(EXIT_FAILURE);
@@ -43,6 +45,8 @@ int main(int argc, char **argv)
         {"step_cutoff", optional_argument, NULL, 6},
         {"time_cutoff", optional_argument, NULL, 7},
         {"checkpoint", required_argument, NULL, 8},
+        {"synchronous", required_argument, NULL, 9},
+        {"trajectory_file", required_argument, NULL, 10},
         {NULL, 0, NULL, 0}
         // last element of options array needs to be filled with zeros
     };
@@ -56,6 +60,8 @@ int main(int argc, char **argv)
     int base_seed = 0;
     int thread_count = 0;
     bool isCheckpoint = false;
+    std::string synchronous = "normal";
+    std::string trajectory_file = "";
 
     Cutoff cutoff = {
         .bound = {.step = 0},
@@ -104,6 +110,14 @@ int main(int argc, char **argv)
             isCheckpoint = atof(optarg);
             break;
 
+        case 9:
+            synchronous = optarg;
+            break;
+
+        case 10:
+            trajectory_file = optarg;
+            break;
+
         default:
             // if an unexpected argument is passed, exit
             print_usage();
@@ -112,6 +126,18 @@ int main(int argc, char **argv)
         }
     }
 
+    if (synchronous != "normal" && synchronous != "off")
+    {
+        std::cout << "Unknown synchronous mode: " << synchronous << "\n";
+        print_usage();
+        exit(EXIT_FAILURE);
+    }
+
+    SqlWriteProfile write_profile{
+        .synchronous = synchronous == "off" ? "OFF" : "NORMAL",
+        .cache_size_mib = default_cache_size_mib,
+        .mmap_size_mib = default_mmap_size_mib};
+
     NanoParticleParameters parameters{
         .isCheckpoint = isCheckpoint};
 
@@ -138,7 +164,9 @@ int main(int argc, char **argv)
             base_seed,
             thread_count,
             cutoff,
-            parameters);
+            parameters,
+            write_profile,
+            trajectory_file);
 
     dispatcher.run_dispatcher();
     exit(EXIT_SUCCESS);
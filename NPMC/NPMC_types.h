@@ -39,13 +39,17 @@ struct NanoSite
 // of upto two sites and the interaction id.
 // if it is an internal interaction, site_id_2 will be -1
 // In a reaction, the sites must be within the interaction radius bound.
+// The interaction data is stored once in NanoParticle::all_interactions,
+// indexed by interaction id, so a reaction is only 24 bytes.
 struct NanoReaction
 {
     int site_id[2];
-    Interaction interaction;
+    int interaction_id;
 
     // rate has units 1 / s
     double rate;
+
+    int number_of_sites() const { return site_id[1] < 0 ? 1 : 2; };
 };
 
 #endif
\ No newline at end of file
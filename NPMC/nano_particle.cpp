@@ -5,6 +5,9 @@ https://blaugroup.github.io/RNMC/
 See the README file in the top-level RNMC directory.
 ---------------------------------------------------------------------- */
 
+#include <algorithm>
+#include <limits>
+
 #include "nano_particle.h"
 
 NanoParticle::NanoParticle() {
@@ -101,10 +104,6 @@ NanoParticle::NanoParticle(
 
     // initializing sites
     sites.resize(metadata_row.number_of_sites);
-    site_reaction_dependency.resize(metadata_row.number_of_sites);
-    // for ( unsigned int i = 0; i < site_reaction_dependency.size(); i++) {
-    //     site_reaction_dependency[i].resize(0);
-    // }
 
     while (std::optional<SiteSql> maybe_site_row =
                site_reader.next())
@@ -119,10 +118,7 @@ NanoParticle::NanoParticle(
     }
 
     // initialize interactions
-    // interactions.resize(metadata_row.number_of_interactions);
-    int num_species = metadata_row.number_of_species;
     int interaction_counter = 0;
-    int num_states = 0; // Keep track of number of states, so axis 2 and 3 in interaction_map can be resized
     while (std::optional<InteractionSql> maybe_interaction_row =
                interactions_reader.next())
     {
@@ -138,60 +134,12 @@ NanoParticle::NanoParticle(
             .rate = interaction_row.rate};
 
         all_interactions.push_back(interaction);
-        if (interaction_row.number_of_sites == 1)
-        {
-            one_site_interactions.push_back(interaction);
-        }
-        else if (interaction_row.number_of_sites == 2)
-        {
-            two_site_interactions.push_back(interaction);
-        }
-
-        if (num_states < interaction_row.left_state_1)
-        {
-            // Keep track of the max number of states
-            num_states = interaction_row.left_state_1;
-        }
 
         // Increment the interaction counter
         interaction_counter++;
     }
-    // Increment the state counter, since this value will be off by 1
-    num_states++;
-
-    // Resize interaction_maps
-    one_site_interactions_map.resize(num_species);
-    for (int i = 0; i < num_species; i++)
-    {
-        one_site_interactions_map[i].resize(num_states);
-    }
-
-    two_site_interactions_map.resize(num_species);
-    for (int i = 0; i < num_species; i++)
-    {
-        two_site_interactions_map[i].resize(num_species);
-        for (int j = 0; j < num_species; j++)
-        {
-            two_site_interactions_map[i][j].resize(num_states);
-            for (int k = 0; k < num_states; k++)
-            {
-                two_site_interactions_map[i][j][k].resize(num_states);
-            }
-        }
-    }
-
-    // Put interactions into interaction_map
-    for (unsigned int i = 0; i < one_site_interactions.size(); i++)
-    {
-        Interaction interaction = one_site_interactions[i];
-        one_site_interactions_map[interaction.species_id[0]][interaction.left_state[0]].push_back(interaction);
-    }
 
-    for (unsigned int i = 0; i < two_site_interactions.size(); i++)
-    {
-        Interaction interaction = two_site_interactions[i];
-        two_site_interactions_map[interaction.species_id[0]][interaction.species_id[1]][interaction.left_state[0]][interaction.left_state[1]].push_back(interaction);
-    }
+    compute_interaction_tables();
 
     // initialize initial_state
     initial_state.resize(metadata_row.number_of_sites);
@@ -203,8 +151,14 @@ NanoParticle::NanoParticle(
         initial_state[initial_state_row.site_id] = initial_state_row.degree_of_freedom;
     }
 
-    // Pre-compute the distance matrix so that it doesn't need to be computed multiple times
-    compute_distance_matrix();
+    // find the neighbors of every site once, reactions only ever
+    // involve a site and one of its neighbors
+    compute_site_neighbors();
+    compute_neighbor_distance_factors();
+
+    // every seed which starts from the initial state starts with the same
+    // reactions, so compute them once and let the simulations copy them
+    compute_reactions(initial_state, initial_reactions, site_reaction_dependency);
 } // NanoParticle()
 
 /* ---------------------------------------------------------------------- */
@@ -226,87 +180,280 @@ double NanoParticle::site_distance_squared(NanoSite s1, NanoSite s2)
 void NanoParticle::compute_reactions(
     const std::vector<int> &state,
     std::vector<NanoReaction> &reactions,
-    std::vector<std::set<int>> &site_reaction_dependency)
+    SiteReactionLists &site_reaction_dependency)
 {
 
+    site_reaction_dependency.reset(sites.size());
+
     int reaction_count = 0;
     for (unsigned int site_id_0 = 0; site_id_0 < sites.size(); site_id_0++)
     {
         // Add one site interactions
-        int site_0_state = state[site_id_0];
-        int site_0_species_id = sites[site_id_0].species_id;
-        std::vector<Interaction> *available_interactions = &one_site_interactions_map[site_0_species_id][site_0_state];
-        for (unsigned int i = 0; i < available_interactions->size(); i++)
+        int site_0_species_state = species_state_offset[sites[site_id_0].species_id] + state[site_id_0];
+        for (int i = one_site_interaction_offsets[site_0_species_state];
+             i < one_site_interaction_offsets[site_0_species_state + 1]; i++)
         {
-            Interaction interaction = (*available_interactions)[i];
+            const Interaction &interaction = one_site_interactions[i];
             NanoReaction reaction = NanoReaction{
                 .site_id = {(int)site_id_0, -1},
-                .interaction = interaction,
+                .interaction_id = interaction.interaction_id,
                 .rate = interaction.rate * one_site_interaction_factor};
             reactions.push_back(reaction);
-            site_reaction_dependency[site_id_0].insert(reaction_count);
+            site_reaction_dependency.insert(reaction_count, reaction);
             reaction_count++;
         }
 
         // Add two site interactions
-        for (unsigned int site_id_1 = 0; site_id_1 < sites.size(); site_id_1++)
+        for (int k = neighbor_offsets[site_id_0]; k < neighbor_offsets[site_id_0 + 1]; k++)
+        {
+            unsigned int site_id_1 = neighbor_ids[k];
+            int site_1_species_state = species_state_offset[sites[site_id_1].species_id] + state[site_id_1];
+            double distance_factor = neighbor_distance_factors[k];
+
+            // Add reactions where site 0 is the donor
+            int row = site_0_species_state * number_of_species_states + site_1_species_state;
+            for (int i = two_site_interaction_offsets[row]; i < two_site_interaction_offsets[row + 1]; i++)
+            {
+                const Interaction &interaction = two_site_interactions[i];
+                NanoReaction reaction = NanoReaction{
+                    .site_id = {(int)site_id_0, (int)site_id_1},
+                    .interaction_id = interaction.interaction_id,
+                    .rate = distance_factor * interaction.rate * two_site_interaction_factor};
+                reactions.push_back(reaction);
+                site_reaction_dependency.insert(reaction_count, reaction);
+                reaction_count++;
+            }
+
+            // Add reactions where site 1 is the donor
+            row = site_1_species_state * number_of_species_states + site_0_species_state;
+            for (int i = two_site_interaction_offsets[row]; i < two_site_interaction_offsets[row + 1]; i++)
+            {
+                const Interaction &interaction = two_site_interactions[i];
+                NanoReaction reaction = NanoReaction{
+                    .site_id = {(int)site_id_1, (int)site_id_0},
+                    .interaction_id = interaction.interaction_id,
+                    .rate = distance_factor * interaction.rate * two_site_interaction_factor};
+                reactions.push_back(reaction);
+                site_reaction_dependency.insert(reaction_count, reaction);
+                reaction_count++;
+            }
+        }
+    }
+} // compute_reactions()
+
+/* ---------------------------------------------------------------------- */
+
+void NanoParticle::compute_interaction_tables()
+{
+    int number_of_species = degrees_of_freedom.size();
+
+    species_state_offset.assign(number_of_species + 1, 0);
+    for (int species_id = 0; species_id < number_of_species; species_id++)
+    {
+        species_state_offset[species_id + 1] =
+            species_state_offset[species_id] + degrees_of_freedom[species_id];
+    }
+    number_of_species_states = species_state_offset[number_of_species];
+
+    // species state of a site of the given species in the given state
+    auto species_state = [&](const Interaction &interaction, int species_id, int state)
+    {
+        if (species_id < 0 || species_id >= number_of_species ||
+            state < 0 || state >= degrees_of_freedom[species_id])
+        {
+            std::cerr << time::time_stamp()
+                      << "interaction " << interaction.interaction_id
+                      << " has species " << species_id
+                      << " in state " << state
+                      << " which is not one of its degrees of freedom\n";
+
+            std::abort();
+        }
+        return species_state_offset[species_id] + state;
+    };
+
+    // row of each interaction in its table, -1 for one site interactions
+    // in the two site table and vice versa
+    std::vector<int> one_site_row(all_interactions.size(), -1);
+    std::vector<int> two_site_row(all_interactions.size(), -1);
+    one_site_interaction_offsets.assign(number_of_species_states + 1, 0);
+    two_site_interaction_offsets.assign(number_of_species_states * number_of_species_states + 1, 0);
+
+    for (unsigned int i = 0; i < all_interactions.size(); i++)
+    {
+        const Interaction &interaction = all_interactions[i];
+        int row = species_state(interaction, interaction.species_id[0], interaction.left_state[0]);
+        species_state(interaction, interaction.species_id[0], interaction.right_state[0]);
+
+        if (interaction.number_of_sites == 1)
+        {
+            one_site_row[i] = row;
+            one_site_interaction_offsets[row + 1]++;
+        }
+        else if (interaction.number_of_sites == 2)
+        {
+            row = row * number_of_species_states +
+                  species_state(interaction, interaction.species_id[1], interaction.left_state[1]);
+            species_state(interaction, interaction.species_id[1], interaction.right_state[1]);
+
+            two_site_row[i] = row;
+            two_site_interaction_offsets[row + 1]++;
+        }
+    }
+
+    for (unsigned int row = 1; row < one_site_interaction_offsets.size(); row++)
+        one_site_interaction_offsets[row] += one_site_interaction_offsets[row - 1];
+    for (unsigned int row = 1; row < two_site_interaction_offsets.size(); row++)
+        two_site_interaction_offsets[row] += two_site_interaction_offsets[row - 1];
+
+    // place the interactions, in order of interaction id within each row
+    one_site_interactions.resize(one_site_interaction_offsets.back());
+    two_site_interactions.resize(two_site_interaction_offsets.back());
+    std::vector<int> one_site_fill(one_site_interaction_offsets.begin(), one_site_interaction_offsets.end() - 1);
+    std::vector<int> two_site_fill(two_site_interaction_offsets.begin(), two_site_interaction_offsets.end() - 1);
+
+    for (unsigned int i = 0; i < all_interactions.size(); i++)
+    {
+        if (one_site_row[i] >= 0)
+            one_site_interactions[one_site_fill[one_site_row[i]]++] = all_interactions[i];
+        else if (two_site_row[i] >= 0)
+            two_site_interactions[two_site_fill[two_site_row[i]]++] = all_interactions[i];
+    }
+} // compute_interaction_tables()
+
+/* ---------------------------------------------------------------------- */
+
+void NanoParticle::compute_site_neighbors()
+{
+    int number_of_sites = sites.size();
+
+    neighbor_offsets.assign(number_of_sites + 1, 0);
+    neighbor_ids.clear();
+    neighbor_distances.clear();
+
+    if (number_of_sites == 0)
+        return;
+
+    // bounding box of the sites
+    double low[3], high[3];
+    for (int d = 0; d < 3; d++)
+    {
+        low[d] = std::numeric_limits<double>::infinity();
+        high[d] = -std::numeric_limits<double>::infinity();
+    }
+
+    for (NanoSite &site : sites)
+    {
+        double coordinates[3] = {site.x, site.y, site.z};
+        for (int d = 0; d < 3; d++)
+        {
+            low[d] = std::min(low[d], coordinates[d]);
+            high[d] = std::max(high[d], coordinates[d]);
+        }
+    }
+
+    // the cells are at least interaction_radius_bound wide along each
+    // axis. their number is capped at about two per site along each
+    // axis so a tiny radius does not create mostly empty cells.
+    int max_cells_per_axis = std::max(1, static_cast<int>(2 * std::cbrt(number_of_sites)));
+    int cells_per_axis[3];
+    double cell_width[3];
+    for (int d = 0; d < 3; d++)
+    {
+        double cells = std::floor((high[d] - low[d]) / interaction_radius_bound);
+        if (!(cells >= 1))
+            cells = 1;
+        cells_per_axis[d] = std::min(static_cast<double>(max_cells_per_axis), cells);
+        cell_width[d] = (high[d] - low[d]) / cells_per_axis[d];
+    }
+
+    auto cell_coordinate = [&](double coordinate, int d)
+    {
+        if (cells_per_axis[d] == 1)
+            return 0;
+        int c = static_cast<int>((coordinate - low[d]) / cell_width[d]);
+        return std::min(c, cells_per_axis[d] - 1);
+    };
+
+    auto cell_index = [&](int cx, int cy, int cz)
+    {
+        return (cx * cells_per_axis[1] + cy) * cells_per_axis[2] + cz;
+    };
+
+    // sort the sites into cells
+    int number_of_cells = cells_per_axis[0] * cells_per_axis[1] * cells_per_axis[2];
+    std::vector<int> site_cell(number_of_sites);
+    std::vector<int> cell_offsets(number_of_cells + 1, 0);
+    std::vector<int> cell_sites(number_of_sites);
+
+    for (int i = 0; i < number_of_sites; i++)
+    {
+        site_cell[i] = cell_index(cell_coordinate(sites[i].x, 0),
+                                  cell_coordinate(sites[i].y, 1),
+                                  cell_coordinate(sites[i].z, 2));
+        cell_offsets[site_cell[i] + 1]++;
+    }
+
+    for (int c = 0; c < number_of_cells; c++)
+        cell_offsets[c + 1] += cell_offsets[c];
+
+    std::vector<int> cell_fill(cell_offsets.begin(), cell_offsets.end() - 1);
+    for (int i = 0; i < number_of_sites; i++)
+        cell_sites[cell_fill[site_cell[i]]++] = i;
+
+    // test the sites in the cells around each site. the neighbors are
+    // sorted by site id so reactions are generated in the same order as
+    // when every pair of sites was tested.
+    std::vector<std::pair<int, double>> neighbors;
+    for (int i = 0; i < number_of_sites; i++)
+    {
+        int c = site_cell[i];
+        int cz = c % cells_per_axis[2];
+        int cy = (c / cells_per_axis[2]) % cells_per_axis[1];
+        int cx = c / (cells_per_axis[2] * cells_per_axis[1]);
+
+        neighbors.clear();
+        for (int x = std::max(cx - 1, 0); x <= std::min(cx + 1, cells_per_axis[0] - 1); x++)
         {
-            if ((unsigned)site_id_0 != site_id_1)
+            for (int y = std::max(cy - 1, 0); y <= std::min(cy + 1, cells_per_axis[1] - 1); y++)
             {
-                int site_1_state = state[site_id_1];
-                int site_1_species_id = sites[site_id_1].species_id;
-                double distance = distance_matrix[site_id_0][site_id_1];
-                if (distance < interaction_radius_bound)
+                for (int z = std::max(cz - 1, 0); z <= std::min(cz + 1, cells_per_axis[2] - 1); z++)
                 {
-                    // Add reactions where site 0 is the donor
-                    std::vector<Interaction> *available_interactions = &two_site_interactions_map[site_0_species_id][site_1_species_id][site_0_state][site_1_state];
-                    for (unsigned int i = 0; i < available_interactions->size(); i++)
+                    int other_cell = cell_index(x, y, z);
+                    for (int k = cell_offsets[other_cell]; k < cell_offsets[other_cell + 1]; k++)
                     {
-                        Interaction interaction = (*available_interactions)[i];
-                        NanoReaction reaction = NanoReaction{
-                            .site_id = {(int)site_id_0, (int)site_id_1},
-                            .interaction = interaction,
-                            .rate = distance_factor_function(distance) * interaction.rate * two_site_interaction_factor};
-                        reactions.push_back(reaction);
-                        site_reaction_dependency[site_id_0].insert(reaction_count);
-                        site_reaction_dependency[site_id_1].insert(reaction_count);
-                        reaction_count++;
-                    }
+                        int j = cell_sites[k];
+                        if (j == i)
+                            continue;
 
-                    // Add reactions where site 1 is the donor
-                    available_interactions = &two_site_interactions_map[site_1_species_id][site_0_species_id][site_1_state][site_0_state];
-                    for (unsigned int i = 0; i < available_interactions->size(); i++)
-                    {
-                        Interaction interaction = (*available_interactions)[i];
-                        NanoReaction reaction = NanoReaction{
-                            .site_id = {(int)site_id_1, (int)site_id_0},
-                            .interaction = interaction,
-                            .rate = distance_factor_function(distance) * interaction.rate * two_site_interaction_factor};
-                        reactions.push_back(reaction);
-                        site_reaction_dependency[site_id_0].insert(reaction_count);
-                        site_reaction_dependency[site_id_1].insert(reaction_count);
-                        reaction_count++;
+                        double distance = std::sqrt(site_distance_squared(sites[i], sites[j]));
+                        if (distance < interaction_radius_bound)
+                            neighbors.push_back(std::make_pair(j, distance));
                     }
                 }
             }
         }
+
+        std::sort(neighbors.begin(), neighbors.end());
+        for (std::pair<int, double> &neighbor : neighbors)
+        {
+            neighbor_ids.push_back(neighbor.first);
+            neighbor_distances.push_back(neighbor.second);
+        }
+        neighbor_offsets[i + 1] = neighbor_ids.size();
     }
-} // compute_reactions()
+} // compute_site_neighbors()
 
 /* ---------------------------------------------------------------------- */
 
-void NanoParticle::compute_distance_matrix()
+void NanoParticle::compute_neighbor_distance_factors()
 {
-    distance_matrix.resize(sites.size());
-    for (unsigned int i = 0; i < sites.size(); i++)
+    neighbor_distance_factors.resize(neighbor_distances.size());
+    for (unsigned int k = 0; k < neighbor_distances.size(); k++)
     {
-        distance_matrix[i].resize(sites.size());
-        for (unsigned int j = 0; j < sites.size(); j++)
-        {
-            distance_matrix[i][j] = std::sqrt(site_distance_squared(sites[i], sites[j]));
-        }
+        neighbor_distance_factors[k] = distance_factor_function(neighbor_distances[k]);
     }
-} // compute_distance_matrix()
+} // compute_neighbor_distance_factors()
 
 /* ---------------------------------------------------------------------- */
 
@@ -315,7 +462,7 @@ void NanoParticle::update_state(
     NanoReaction reaction)
 {
 
-    Interaction interaction = reaction.interaction;
+    Interaction &interaction = all_interactions[reaction.interaction_id];
 
     for (int k = 0; k < interaction.number_of_sites; k++)
     {
@@ -345,60 +492,55 @@ void NanoParticle::compute_new_reactions(
     std::vector<NanoReaction> &new_reactions)
 {
 
-    int site_0_species_id = sites[site_0_id].species_id;
+    int site_0_species_state = species_state_offset[sites[site_0_id].species_id] + site_0_state;
 
     // Add one site interactions
-    std::vector<Interaction> *available_interactions = &one_site_interactions_map[site_0_species_id][site_0_state];
-    for (unsigned int i = 0; i < available_interactions->size(); i++)
+    for (int i = one_site_interaction_offsets[site_0_species_state];
+         i < one_site_interaction_offsets[site_0_species_state + 1]; i++)
     {
-        Interaction interaction = (*available_interactions)[i];
+        const Interaction &interaction = one_site_interactions[i];
         NanoReaction new_reaction = NanoReaction{
             .site_id = {(int)site_0_id, -1},
-            .interaction = interaction,
+            .interaction_id = interaction.interaction_id,
             .rate = interaction.rate * one_site_interaction_factor};
         new_reactions.push_back(new_reaction);
     }
 
     // Add two site interactions
-    for (unsigned int site_1_id = 0; site_1_id < sites.size(); site_1_id++)
+    for (int k = neighbor_offsets[site_0_id]; k < neighbor_offsets[site_0_id + 1]; k++)
     {
-        if ((unsigned)site_0_id != site_1_id)
+        unsigned int site_1_id = neighbor_ids[k];
+        int site_1_species_state = species_state_offset[sites[site_1_id].species_id] + state[site_1_id];
+
+        double distance_factor = neighbor_distance_factors[k];
+
+        // Add reactions where site 0 is the donor
+        int row = site_0_species_state * number_of_species_states + site_1_species_state;
+        for (int i = two_site_interaction_offsets[row]; i < two_site_interaction_offsets[row + 1]; i++)
         {
-            int site_1_state = state[site_1_id];
-            int site_1_species_id = sites[site_1_id].species_id;
+            const Interaction &interaction = two_site_interactions[i];
+            NanoReaction new_reaction = NanoReaction{
+                .site_id = {(int)site_0_id, (int)site_1_id},
+                .interaction_id = interaction.interaction_id,
+                .rate = distance_factor * interaction.rate * two_site_interaction_factor};
+            new_reactions.push_back(new_reaction);
+        }
 
-            const double *distance = &distance_matrix[site_0_id][site_1_id];
-            if (*distance < interaction_radius_bound)
+        // This if check is necessary so we don't doubly add reactions.
+        // i.e. if our reaction which fired involves sites 11 and 22, we want to only add 11->22 and 22->11 once.
+        // If this check isn't here, we add 11->22 and 22->11 twice
+        if (site_1_id != (unsigned)other_site_id)
+        {
+            // Add reactions where site 1 is the donor
+            row = site_1_species_state * number_of_species_states + site_0_species_state;
+            for (int i = two_site_interaction_offsets[row]; i < two_site_interaction_offsets[row + 1]; i++)
             {
-                // Add reactions where site 0 is the donor
-                std::vector<Interaction> *available_interactions = &two_site_interactions_map[site_0_species_id][site_1_species_id][site_0_state][site_1_state];
-                for (unsigned int i = 0; i < available_interactions->size(); i++)
-                {
-                    Interaction interaction = (*available_interactions)[i];
-                    NanoReaction new_reaction = NanoReaction{
-                        .site_id = {(int)site_0_id, (int)site_1_id},
-                        .interaction = interaction,
-                        .rate = distance_factor_function(*distance) * interaction.rate * two_site_interaction_factor};
-                    new_reactions.push_back(new_reaction);
-                }
-
-                // This if check is necessary so we don't doubly add reactions.
-                // i.e. if our reaction which fired involves sites 11 and 22, we want to only add 11->22 and 22->11 once.
-                // If this check isn't here, we add 11->22 and 22->11 twice
-                if (site_1_id != (unsigned)other_site_id)
-                {
-                    // Add reactions where site 1 is the donor
-                    available_interactions = &two_site_interactions_map[site_1_species_id][site_0_species_id][site_1_state][site_0_state];
-                    for (unsigned int i = 0; i < available_interactions->size(); i++)
-                    {
-                        Interaction interaction = (*available_interactions)[i];
-                        NanoReaction new_reaction = NanoReaction{
-                            .site_id = {(int)site_1_id, (int)site_0_id},
-                            .interaction = interaction,
-                            .rate = distance_factor_function(*distance) * interaction.rate * two_site_interaction_factor};
-                        new_reactions.push_back(new_reaction);
-                    }
-                }
+                const Interaction &interaction = two_site_interactions[i];
+                NanoReaction new_reaction = NanoReaction{
+                    .site_id = {(int)site_1_id, (int)site_0_id},
+                    .interaction_id = interaction.interaction_id,
+                    .rate = distance_factor * interaction.rate * two_site_interaction_factor};
+                new_reactions.push_back(new_reaction);
             }
         }
     }
@@ -409,151 +551,148 @@ void NanoParticle::compute_new_reactions(
 void NanoParticle::update_reactions(
     const std::vector<int> &state,
     NanoReaction reaction,
-    std::vector<std::set<int>> &current_site_reaction_dependency,
-    std::vector<NanoReaction> &current_reactions)
+    SiteReactionLists &current_site_reaction_dependency,
+    std::vector<NanoReaction> &current_reactions,
+    std::vector<int> &changed_reactions,
+    NanoReactionScratch &scratch)
 {
 
+    std::vector<NanoReaction> &new_reactions = scratch.new_reactions;
+    std::vector<int> &free_slots = scratch.free_slots;
+    new_reactions.clear();
+    free_slots.clear();
+
     // Compute the new reactions based on the new states
-    std::vector<NanoReaction> new_reactions;
     const int site_0_id = reaction.site_id[0];
     const int site_0_state = state[site_0_id];
     const int site_1_id = reaction.site_id[1];
     const int site_1_state = state[site_1_id];
     compute_new_reactions(site_0_id, site_1_id, site_0_state, std::cref(state), std::ref(new_reactions));
-    if (reaction.interaction.number_of_sites == 2)
+    if (reaction.number_of_sites() == 2)
     {
         compute_new_reactions(site_1_id, site_0_id, site_1_state, std::cref(state), std::ref(new_reactions));
     }
 
-    // Find indexes of reactions to be removed
-    std::set<int> reactions_to_remove;
-    std::set<int> *reaction_dependency;
-    for (int k = 0; k < reaction.interaction.number_of_sites; k++)
+    // Every reaction involving a site which changed state is removed.
+    // Unlinking a reaction removes it from the lists of both its sites,
+    // so each slot is freed once.
+    for (int k = 0; k < reaction.number_of_sites(); k++)
     {
         int site_id = reaction.site_id[k];
-        reaction_dependency = &current_site_reaction_dependency[site_id];
-
-        std::vector<std::vector<int>> dependencies_to_process;
-        for (std::set<int>::iterator site_reaction_dependency_itr = reaction_dependency->begin();
-             site_reaction_dependency_itr != reaction_dependency->end();
-             site_reaction_dependency_itr++)
+        while (current_site_reaction_dependency.head[site_id] != -1)
         {
-            int reaction_id_to_remove = *site_reaction_dependency_itr;
-            // Append this reaction index to a list of reactions to remove
-            reactions_to_remove.insert(reaction_id_to_remove);
-
-            // Need to remove this interaction from the second site if this is a two_site interaction
-            NanoReaction *reaction_to_remove = &current_reactions[reaction_id_to_remove];
-            dependencies_to_process.push_back({reaction_to_remove->site_id[0], reaction_id_to_remove});
-            if ((*reaction_to_remove).interaction.number_of_sites == 2)
-            {
-                dependencies_to_process.push_back({reaction_to_remove->site_id[1], reaction_id_to_remove});
-            }
+            int slot = current_site_reaction_dependency.head[site_id] / 2;
+            current_site_reaction_dependency.remove(slot, current_reactions[slot]);
+            free_slots.push_back(slot);
         }
+    }
+
+    std::sort(free_slots.begin(), free_slots.end(), std::greater<int>());
 
-        for (unsigned int i = 0; i < dependencies_to_process.size(); i++)
+    // Assign the new reactions to the freed slots, lowest first.
+    // If there are more new reactions than freed slots,
+    // append the excess reactions to the end of the current_reactions vector
+    for (NanoReaction &new_reaction : new_reactions)
+    {
+        int slot;
+        if (!free_slots.empty())
+        {
+            slot = free_slots.back();
+            free_slots.pop_back();
+            current_reactions[slot] = new_reaction;
+        }
+        else
         {
-            std::vector<int> *dependency_to_process = &dependencies_to_process[i];
-            current_site_reaction_dependency[(*dependency_to_process)[0]].erase((*dependency_to_process)[1]);
+            slot = current_reactions.size();
+            current_reactions.push_back(new_reaction);
         }
+
+        changed_reactions.push_back(slot);
+        current_site_reaction_dependency.insert(slot, new_reaction);
     }
 
-    // Add the new reactions to the current_reactions vector
-    int n_reactions_to_remove = reactions_to_remove.size();
-    std::set<int>::iterator reactions_to_remove_itr = reactions_to_remove.begin();
-    for (unsigned int i = 0; i < new_reactions.size(); i++)
+    // Fill the slots which are still free, lowest first, with the
+    // reactions at the end of current_reactions so it stays contiguous.
+    // free_slots[top] is the highest free slot the scan from the end has
+    // not reached yet, free_slots[lowest] the lowest slot not yet filled.
+    int number_of_free_slots = free_slots.size();
+    int lowest = number_of_free_slots - 1;
+    int top = 0;
+    int reaction_idx_to_move = (int)current_reactions.size() - 1;
+    while (lowest >= top && reaction_idx_to_move >= free_slots[lowest])
     {
-        NanoReaction *new_reaction = &new_reactions[i];
-        if (i < (unsigned)n_reactions_to_remove)
+        if (reaction_idx_to_move == free_slots[top])
         {
-            // Assign the new reaction to a index belonging to a reaction to remove.
-            // Since the reaction is going to be deleted anyways, this is safe.
-            // Additionally, this avoids additional copy operations
-            current_reactions[*reactions_to_remove_itr] = *new_reaction;
-            for (int k = 0; k < (*new_reaction).interaction.number_of_sites; k++)
-            {
-                current_site_reaction_dependency[new_reaction->site_id[k]].insert(*reactions_to_remove_itr);
-            }
-            // reactions_to_remove.erase(reactions_to_remove_itr++);
-            reactions_to_remove_itr++;
+            // Reaction to be moved has been removed, no point in moving it
+            top++;
         }
         else
         {
-            // If the number of new reactions to be added is larger than the number of reactions to remove,
-            // just append the excess reactions to the end of the current_reactions vector
-            current_reactions.push_back(*new_reaction);
-            for (int k = 0; k < (*new_reaction).interaction.number_of_sites; k++)
-            {
-                current_site_reaction_dependency[new_reaction->site_id[k]].insert(current_reactions.size() - 1);
-            }
+            int slot = free_slots[lowest];
+            current_site_reaction_dependency.remove(reaction_idx_to_move,
+                                                    current_reactions[reaction_idx_to_move]);
+            current_reactions[slot] = current_reactions[reaction_idx_to_move];
+            current_site_reaction_dependency.insert(slot, current_reactions[slot]);
+            changed_reactions.push_back(slot);
+            lowest--;
         }
+        reaction_idx_to_move--;
     }
 
-    int net_change_in_num_reactions = new_reactions.size() - reactions_to_remove.size();
-    if (reactions_to_remove_itr != reactions_to_remove.end() && net_change_in_num_reactions < 0)
-    {
-        // Don't need to do anything with the reactions_to_remove_itr, since it already points to the
-        // last reaction that has yet to be removed (a result of the last code block)
+    current_reactions.resize(current_reactions.size() - number_of_free_slots);
 
-        // Create a new variable keeping track of which reaction (within current_reactions) we are checking.
-        // This will start at the end of current_reactions.
-        int reaction_idx_to_move = (int)current_reactions.size() - 1;
-        int reactions_moved = 0;
-        while (reactions_to_remove_itr != reactions_to_remove.end() &&
-               reactions_moved > net_change_in_num_reactions &&
-               reaction_idx_to_move >= *reactions_to_remove_itr)
-        {
-            // Check if the reaction to be moved is in the list of reactions to remove
-            auto result = reactions_to_remove.find(reaction_idx_to_move);
-            if (result != reactions_to_remove.end())
-            {
-                // Reaction to be moved is going to be removed, no point in removing it
-                reaction_idx_to_move--;
-            }
-            else
-            {
-                NanoReaction reaction_to_move = current_reactions[reaction_idx_to_move];
-                current_reactions[*reactions_to_remove_itr] = reaction_to_move;
+} // update_reactions()
 
-                // Find the reaction that was moved in the site reaction dependency vector and remap it
-                for (int k = 0; k < reaction_to_move.interaction.number_of_sites; k++)
-                {
-                    int site_id = reaction_to_move.site_id[k];
-                    // This number should always be in the list, else something has gone wrong
-                    int num_reactions_deleted = current_site_reaction_dependency[site_id].erase(reaction_idx_to_move);
+/* ---------------------------------------------------------------------- */
 
-                    if (num_reactions_deleted == 1)
-                    {
-                        current_site_reaction_dependency[site_id].insert(*reactions_to_remove_itr);
-                    }
-                    else if (num_reactions_deleted == 0)
-                    {
-                        std::cerr << "Could not find reaction "
-                                  << reaction_idx_to_move
-                                  << " in the site reaction dependency map for site "
-                                  << site_id
-                                  << "\n";
-                        raise(SIGINT);
-                    }
-                    else
-                    {
-                        std::cerr << "Encountered multiple occurances of "
-                                  << reaction_idx_to_move
-                                  << " in the site reaction dependency map for site "
-                                  << site_id
-                                  << "\n";
-                        raise(SIGINT);
-                    }
-                }
-                reaction_idx_to_move--;
-                reactions_to_remove_itr++;
-                reactions_moved++;
-            }
-        }
-        current_reactions.resize(current_reactions.size() + net_change_in_num_reactions);
+void SiteReactionLists::reset(int number_of_sites)
+{
+    head.assign(number_of_sites, -1);
+    next.clear();
+    previous.clear();
+} // reset()
+
+/* ---------------------------------------------------------------------- */
+
+void SiteReactionLists::insert(int slot, const NanoReaction &reaction)
+{
+    if (next.size() < 2 * (unsigned)slot + 2)
+    {
+        next.resize(2 * slot + 2);
+        previous.resize(2 * slot + 2);
     }
 
-} // update_reactions()
+    for (int k = 0; k < reaction.number_of_sites(); k++)
+    {
+        int site_id = reaction.site_id[k];
+        int link = 2 * slot + k;
+
+        previous[link] = -1;
+        next[link] = head[site_id];
+        if (head[site_id] != -1)
+            previous[head[site_id]] = link;
+        head[site_id] = link;
+    }
+} // insert()
+
+/* ---------------------------------------------------------------------- */
+
+void SiteReactionLists::remove(int slot, const NanoReaction &reaction)
+{
+    for (int k = 0; k < reaction.number_of_sites(); k++)
+    {
+        int site_id = reaction.site_id[k];
+        int link = 2 * slot + k;
+
+        if (previous[link] != -1)
+            next[previous[link]] = next[link];
+        else
+            head[site_id] = next[link];
+
+        if (next[link] != -1)
+            previous[next[link]] = previous[link];
+    }
+} // remove()
 
 /* ---------------------------------------------------------------------- */
 
@@ -562,14 +701,13 @@ NanoWriteTrajectoriesSql NanoParticle::history_element_to_sql(
     NanoTrajectoryHistoryElement history_element)
 {
 
-    NanoReaction reaction = history_element.reaction;
     return NanoWriteTrajectoriesSql{
         .seed = seed,
         .step = history_element.step,
         .time = history_element.time,
-        .site_id_1 = reaction.site_id[0],
-        .site_id_2 = reaction.site_id[1],
-        .interaction_id = reaction.interaction.interaction_id};
+        .site_id_1 = history_element.site_id[0],
+        .site_id_2 = history_element.site_id[1],
+        .interaction_id = history_element.interaction_id};
 } // history_element_to_sql()
 
 /* ---------------------------------------------------------------------- */
@@ -604,20 +742,17 @@ void NanoParticle::checkpoint(SqlReader<NanoReadStateSql> state_reader,
                               SqlReader<NanoReadTrajectoriesSql> trajectory_reader,
                               std::map<int, std::vector<int>> &temp_seed_state_map,
                               std::map<int, int> &temp_seed_step_map,
-                              SeedQueue &temp_seed_queue,
                               std::map<int, double> &temp_seed_time_map,
                               NanoParticle &model)
 {
 
     bool read_interrupt_states = false;
-    std::vector<int> default_state = model.initial_state;
-
-    while (std::optional<unsigned long int> maybe_seed =
-               temp_seed_queue.get_seed())
+    // only seeds with a checkpoint get an entry, starting from a copy
+    // of initial_state. the other seeds copy initial_state when they run.
+    auto seed_state = [&](int seed) -> std::vector<int> &
     {
-        unsigned long int seed = maybe_seed.value();
-        temp_seed_state_map.insert(std::make_pair(seed, default_state));
-    }
+        return temp_seed_state_map.try_emplace(seed, model.initial_state).first->second;
+    };
 
     while (std::optional<ReadCutoffSql> maybe_cutoff_row = cutoff_reader.next())
     {
@@ -633,7 +768,7 @@ void NanoParticle::checkpoint(SqlReader<NanoReadStateSql> state_reader,
         read_interrupt_states = true;
 
         NanoReadStateSql state_row = maybe_state_row.value();
-        temp_seed_state_map[state_row.seed][state_row.site_id] = state_row.degree_of_freedom;
+        seed_state(state_row.seed)[state_row.site_id] = state_row.degree_of_freedom;
     }
 
     // try reading from trajectory
@@ -646,10 +781,10 @@ void NanoParticle::checkpoint(SqlReader<NanoReadStateSql> state_reader,
             NanoReadTrajectoriesSql trajectory_row = maybe_trajectory_row.value();
 
             Interaction *interaction = &model.all_interactions[trajectory_row.interaction_id];
-            temp_seed_state_map[trajectory_row.seed][trajectory_row.site_id_1] = interaction->right_state[0];
+            seed_state(trajectory_row.seed)[trajectory_row.site_id_1] = interaction->right_state[0];
             if (interaction->number_of_sites == 2)
             {
-                temp_seed_state_map[trajectory_row.seed][trajectory_row.site_id_2] = interaction->right_state[1];
+                seed_state(trajectory_row.seed)[trajectory_row.site_id_2] = interaction->right_state[1];
             }
 
             if (trajectory_row.step > temp_seed_step_map[trajectory_row.seed])
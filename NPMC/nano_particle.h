@@ -14,6 +14,37 @@
 #include <set>
 #include <map>
 
+// for every site, the slots of the current reactions which involve the
+// site. the lists are doubly linked through arrays indexed by link, where
+// link 2 * slot + k belongs to site_id[k] of the reaction in that slot,
+// so a reaction is added, removed or moved in O(1). the arrays only grow
+// when a slot is used for the first time, after that no operation
+// allocates.
+struct SiteReactionLists {
+    std::vector<int> head;     // first link of each site, -1 if none
+    std::vector<int> next;     // next link of the same site, -1 if none
+    std::vector<int> previous; // previous link of the same site, -1 if none
+
+    // empty lists for number_of_sites sites
+    void reset(int number_of_sites);
+
+    // link a reaction stored in slot into the lists of its sites
+    void insert(int slot, const NanoReaction &reaction);
+
+    // unlink the reaction stored in slot from the lists of its sites
+    void remove(int slot, const NanoReaction &reaction);
+};
+
+// buffers reused by update_reactions, one per simulation, so a step
+// does not allocate
+struct NanoReactionScratch {
+    std::vector<NanoReaction> new_reactions;
+
+    // slots freed by the current step in decreasing order, so the
+    // lowest is popped first
+    std::vector<int> free_slots;
+};
+
 struct NanoParticle {
     // maps a species index to the number of degrees of freedom
     std::vector<int> degrees_of_freedom;
@@ -21,27 +52,46 @@ struct NanoParticle {
     // maps site index to site data
     std::vector<NanoSite> sites;
 
-    // 2D vector representing the pairwise distance between two sites
-    std::vector<std::vector<double>> distance_matrix;
-
-    // maps site ids to sit
+    // neighbor lists in compressed row form. the neighbors of site i
+    // within interaction_radius_bound are
+    // neighbor_ids[neighbor_offsets[i]] ... neighbor_ids[neighbor_offsets[i + 1] - 1]
+    // in increasing order of site id, and neighbor_distances holds the
+    // distance to each of them. neighbor_distance_factors holds
+    // distance_factor_function of each distance, so building a two site
+    // reaction does not need to evaluate it.
+    std::vector<int> neighbor_offsets;
+    std::vector<int> neighbor_ids;
+    std::vector<double> neighbor_distances;
+    std::vector<double> neighbor_distance_factors;
+
+    // reactions available in initial_state, and the ids of the reactions
+    // involving each site. computed once by the constructor and copied
+    // by every simulation starting from initial_state.
     std::vector<NanoReaction> initial_reactions;
-
-    // Remove this since we don't have concrete reaction_ids
-    // maps site ids to reaction ids involving the site.
-    // TODO: Check if performance is better using std::vector<std::set<int>> or std::vector<std::vector<int>>
-    std::vector<std::set<int>> site_reaction_dependency;
+    SiteReactionLists site_reaction_dependency;
 
     // maps interaction index to interaction data
     std::vector<Interaction> all_interactions;
+
+    // interactions grouped by the species and states of the sites they
+    // act on, in compressed row form. a site of species s in state j is
+    // in species state species_state_offset[s] + j, which is less than
+    // number_of_species_states. the one site interactions of species
+    // state a are
+    // one_site_interactions[one_site_interaction_offsets[a]] ...
+    // one_site_interactions[one_site_interaction_offsets[a + 1] - 1]
+    // and the two site interactions between a donor in species state a
+    // and an acceptor in species state b are found the same way in
+    // two_site_interactions, at row a * number_of_species_states + b of
+    // two_site_interaction_offsets. within a row interactions are in
+    // increasing order of interaction id.
+    std::vector<int> species_state_offset;
+    int number_of_species_states;
+    std::vector<int> one_site_interaction_offsets;
     std::vector<Interaction> one_site_interactions;
+    std::vector<int> two_site_interaction_offsets;
     std::vector<Interaction> two_site_interactions;
 
-    // maps site_0_index, site_0_state to interaction data
-    std::vector<std::vector<std::vector<Interaction>>> one_site_interactions_map;
-    // maps site_0_index, site_1_index, site_0_state, site_1_state to interaction data
-    std::vector<std::vector<std::vector<std::vector<std::vector<Interaction>>>>> two_site_interactions_map;
-
     // initial state of the simulations.
     // initial_state[i] is a local degree of freedom
     // from the species at site i.
@@ -59,6 +109,9 @@ struct NanoParticle {
 
     bool isCheckpoint;
 
+    // distance dependence of two site rates, selected by the
+    // distance_factor_type of the factors table. only evaluated when
+    // the model is loaded, see neighbor_distance_factors.
     std::function<double(double)> distance_factor_function;
 
     NanoParticle (); // default constructor
@@ -71,14 +124,22 @@ struct NanoParticle {
 
     double site_distance_squared(NanoSite s1, NanoSite s2);
 
-    // maps a site index to the indices of its neighbors
-    // within the spatial decay radius
-    std::vector<std::vector<int>> compute_site_neighbors();
+    // fill the interaction tables from all_interactions and
+    // degrees_of_freedom
+    void compute_interaction_tables();
+
+    // fill the neighbor lists using a uniform grid of cells at least
+    // interaction_radius_bound wide, so only the sites in the 27 cells
+    // around a site are tested instead of every other site
+    void compute_site_neighbors();
+
+    // evaluate distance_factor_function for every neighbor pair
+    void compute_neighbor_distance_factors();
 
     void compute_reactions(
         const std::vector<int> &state,
-        std::vector<NanoReaction> &reactions,    
-        std::vector<std::set<int>> &site_reaction_dependency
+        std::vector<NanoReaction> &reactions,
+        SiteReactionLists &site_reaction_dependency
     );
     void compute_new_reactions(
         const int site_0_id,
@@ -88,26 +149,25 @@ struct NanoParticle {
         std::vector<NanoReaction> &new_reactions
     );
 
-    void compute_distance_matrix();
-
     void update_state(
         std::vector<int> &state,
         NanoReaction reaction
     );
 
-    // updates are passed directly to the solver, but the model
-    // classes don't have a reference to the solver (otherwise,
-    // the would need to be parameterized over a Solver type, which
-    // feels akward). The way around this is that the model class computes
-    // all the propensity updates required, and then passes them into an
-    // update_function lambda which is generated by the Simulation class from
-    // core.
+    // the current reactions are owned by the solver and modified in
+    // place. the indices of every reaction which is overwritten or
+    // appended are added to changed_reactions so the solver only has
+    // to update those, reactions past the new end of current_reactions
+    // have been removed. once the buffers have grown to the largest
+    // number of reactions seen, this does not allocate.
 
     void update_reactions(
         const std::vector<int> &state,
         NanoReaction reaction,
-        std::vector<std::set<int>> &current_site_reaction_dependency,
-        std::vector<NanoReaction> &current_reactions);
+        SiteReactionLists &current_site_reaction_dependency,
+        std::vector<NanoReaction> &current_reactions,
+        std::vector<int> &changed_reactions,
+        NanoReactionScratch &scratch);
 
     // convert a history element as found a simulation to history
     // to a SQL type.
@@ -128,7 +188,6 @@ struct NanoParticle {
         SqlReader<NanoReadTrajectoriesSql> trajectory_reader, 
         std::map<int, std::vector<int>> &temp_seed_state_map, 
         std::map<int, int> &temp_seed_step_map, 
-        SeedQueue &temp_seed_queue, 
         std::map<int, double> &temp_seed_time_map, 
         NanoParticle &model);
 
@@ -10,7 +10,8 @@ See the README file in the top-level RNMC directory.
 NanoSolver::NanoSolver(
     unsigned long int seed,
     std::vector<NanoReaction> &&current_reactions) : sampler(Sampler(seed)),
-                                                     cumulative_propensities(current_reactions.size()),
+                                                     number_of_slots(0),
+                                                     number_of_indices(0),
                                                      number_of_active_indices(0),
                                                      propensity_sum(0.0),
                                                      // if this move isn't here, the semantics is that initial
@@ -27,7 +28,8 @@ NanoSolver::NanoSolver(
 NanoSolver::NanoSolver(
     unsigned long int seed,
     std::vector<NanoReaction> &current_reactions) : sampler(Sampler(seed)),
-                                                    cumulative_propensities(current_reactions.size()),
+                                                    number_of_slots(0),
+                                                    number_of_indices(0),
                                                     number_of_active_indices(0),
                                                     propensity_sum(0.0),
                                                     current_reactions(current_reactions)
@@ -40,28 +42,111 @@ NanoSolver::NanoSolver(
 
 void NanoSolver::update()
 {
-    cumulative_propensities.resize(current_reactions.size());
-    number_of_active_indices = cumulative_propensities.size();
-    // std::cerr << "Propensities are: ";
-    if (number_of_active_indices > 0)
+    number_of_slots = 1; // power of 2 >= number of reactions
+    while (number_of_slots < current_reactions.size())
     {
-        cumulative_propensities[0] = current_reactions[0].rate;
-        // std::cerr << current_reactions[0].rate << ", ";
+        number_of_slots *= 2;
+    };
+
+    tree.assign(2 * number_of_slots - 1, 0.0);
+
+    unsigned long int propensity_offset = number_of_slots - 1;
+    for (unsigned long int i = 0; i < current_reactions.size(); i++)
+    {
+        tree[propensity_offset + i] = current_reactions[i].rate;
+    }
+
+    for (long int parent = propensity_offset - 1; parent >= 0; parent--)
+    {
+        tree[parent] = tree[2 * parent + 1] + tree[2 * parent + 2];
+    };
+
+    number_of_indices = current_reactions.size();
+    number_of_active_indices = number_of_indices;
+    propensity_sum = tree[0];
+
+} // update()
+
+/* ---------------------------------------------------------------------- */
+
+void NanoSolver::update(std::vector<int> &changed_reactions)
+{
+    // rebuild if the reactions no longer fit in the tree
+    if (current_reactions.size() > number_of_slots)
+    {
+        update();
+        return;
+    }
+
+    unsigned long int propensity_offset = number_of_slots - 1;
+    dirty_nodes.clear();
+
+    // reactions which were dropped from the end of the list
+    for (unsigned long int i = current_reactions.size(); i < number_of_indices; i++)
+    {
+        tree[propensity_offset + i] = 0.0;
+        dirty_nodes.push_back(propensity_offset + i);
     }
 
-    for (unsigned int i = 1; i < current_reactions.size(); i++)
+    for (int i : changed_reactions)
     {
-        cumulative_propensities[i] = cumulative_propensities[i - 1] + current_reactions[i].rate;
-        //   std::cerr << current_reactions[i].rate << ", ";
+        if ((unsigned long int)i < current_reactions.size())
+        {
+            tree[propensity_offset + i] = current_reactions[i].rate;
+            dirty_nodes.push_back(propensity_offset + i);
+        }
     }
-    // std::cerr << "\n";
 
-    propensity_sum = cumulative_propensities[cumulative_propensities.size() - 1];
+    // recompute each dirty ancestor once, one level at a time
+    std::sort(dirty_nodes.begin(), dirty_nodes.end());
+    dirty_nodes.erase(std::unique(dirty_nodes.begin(), dirty_nodes.end()),
+                      dirty_nodes.end());
+
+    while (!dirty_nodes.empty() && dirty_nodes[0] > 0)
+    {
+        for (unsigned long int &i : dirty_nodes)
+            i = (i - 1) / 2;
+
+        dirty_nodes.erase(std::unique(dirty_nodes.begin(), dirty_nodes.end()),
+                          dirty_nodes.end());
+
+        for (unsigned long int parent : dirty_nodes)
+            tree[parent] = tree[2 * parent + 1] + tree[2 * parent + 2];
+    }
+
+    number_of_indices = current_reactions.size();
+    number_of_active_indices = number_of_indices;
+    propensity_sum = tree[0];
 
 } // update()
 
 /* ---------------------------------------------------------------------- */
 
+unsigned long int NanoSolver::find_solve_tree(double value)
+{
+    unsigned long int i = 0;
+    unsigned long int propensity_offset = number_of_slots - 1;
+    while (i < propensity_offset)
+    {
+        unsigned long int left_child = 2 * i + 1;
+        if (value <= tree[left_child])
+            i = left_child;
+        else
+        {
+            value -= tree[left_child];
+            i = left_child + 1;
+        }
+    }
+
+    // rounding error can walk us past the last reaction
+    if (i - propensity_offset >= number_of_indices)
+        return number_of_indices - 1;
+
+    return i - propensity_offset;
+} // find_solve_tree()
+
+/* ---------------------------------------------------------------------- */
+
 std::optional<Event> NanoSolver::event()
 {
     if (number_of_active_indices == 0)
@@ -74,21 +159,10 @@ std::optional<Event> NanoSolver::event()
     double r2 = sampler.generate();
     double fraction = propensity_sum * r1;
 
-    unsigned long m;
-
-    // This is a linear search. In the future, use a binary search
-    for (m = 0; m < current_reactions.size(); m++)
-    {
-        if (cumulative_propensities[m] > fraction)
-            break;
-    }
-    // std::cerr << "Propensity sum: " << propensity_sum << "\n";
+    unsigned long m = find_solve_tree(fraction);
 
     double dt = -std::log(r2) / propensity_sum;
-    if (m < current_reactions.size())
-        return std::optional<Event>(Event{.index = m, .dt = dt});
-    else
-        return std::optional<Event>(Event{.index = last_non_zero_event, .dt = dt});
+    return std::optional<Event>(Event{.index = m, .dt = dt});
 
 } // event()
 
@@ -14,33 +14,45 @@ See the README file in the top-level RNMC directory.
 #include <map>
 #include <csignal>
 #include <iostream>
+#include <algorithm>
 
 #include "../core/sampler.h"
 #include "../core/RNMC_types.h"
 #include "NPMC_types.h"
 
-struct NanoUpdate
-{
-    unsigned long int index;
-    NanoReaction reaction; 
-};
+// the propensities of the current reactions are stored as the leaves
+// of a binary sum tree, like the GMC tree solver, so that selecting an
+// event and updating a reaction slot are both O(log N). the tree has
+// room for a power of 2 number of slots and is rebuilt when the list of
+// current reactions outgrows it.
 
 class NanoSolver
 {
 private:
     Sampler sampler;
-    std::vector<double> cumulative_propensities;
+    std::vector<double> tree;                   // we store the propensities in a binary heap
+    unsigned long int number_of_slots;          // number of leaves of the tree
+    unsigned long int number_of_indices;        // number of reactions the tree currently holds
     int number_of_active_indices;
     double propensity_sum;
-    unsigned long int last_non_zero_event;
+    std::vector<unsigned long int> dirty_nodes; // scratch space for updates
+
+    // walk tree from root to appropriate leaf
+    unsigned long int find_solve_tree(double value);
 
 public:
     std::vector<NanoReaction> current_reactions;
     NanoSolver(unsigned long int seed, std::vector<NanoReaction> &current_reactions);
     NanoSolver(unsigned long int seed, std::vector<NanoReaction> &&current_reactions);
+
+    // rebuild the tree from all of current_reactions
     void update();
-    void update(NanoUpdate update);
-    void update(std::vector<NanoUpdate> updates);
+
+    // current_reactions has been modified in place. changed_reactions
+    // lists the slots which were overwritten or appended, slots past
+    // the end of current_reactions have been removed.
+    void update(std::vector<int> &changed_reactions);
+
     std::optional<Event> event();
     double get_propensity(int index);
     double get_propensity_sum();
@@ -5,6 +5,8 @@ https://blaugroup.github.io/RNMC/
 See the README file in the top-level RNMC directory.
 ---------------------------------------------------------------------- */
 
+#include <cstddef>
+
 #include "sql_types.h"
 
 /* --------------------------- SpeciesSql ---------------------------- */
@@ -113,18 +115,25 @@ void NanoReadTrajectoriesSql::action(NanoReadTrajectoriesSql &r, sqlite3_stmt *s
 /* --------------------- Write Trajectories SQL ------------------------- */
 
 std::string NanoWriteTrajectoriesSql::sql_statement =
-    "INSERT INTO trajectories VALUES (?1,?2,?3,?4,?5,?6);";
+    "INSERT OR IGNORE INTO trajectories VALUES (?1,?2,?3,?4,?5,?6);";
 
-void NanoWriteTrajectoriesSql::action(NanoWriteTrajectoriesSql &r, sqlite3_stmt *stmt)
+void NanoWriteTrajectoriesSql::action(NanoWriteTrajectoriesSql &r, sqlite3_stmt *stmt, int first_parameter)
 {
-    sqlite3_bind_int(stmt, 1, r.seed);
-    sqlite3_bind_int(stmt, 2, r.step);
-    sqlite3_bind_double(stmt, 3, r.time);
-    sqlite3_bind_int(stmt, 4, r.site_id_1);
-    sqlite3_bind_int(stmt, 5, r.site_id_2);
-    sqlite3_bind_int(stmt, 6, r.interaction_id);
+    sqlite3_bind_int(stmt, first_parameter, r.seed);
+    sqlite3_bind_int(stmt, first_parameter + 1, r.step);
+    sqlite3_bind_double(stmt, first_parameter + 2, r.time);
+    sqlite3_bind_int(stmt, first_parameter + 3, r.site_id_1);
+    sqlite3_bind_int(stmt, first_parameter + 4, r.site_id_2);
+    sqlite3_bind_int(stmt, first_parameter + 5, r.interaction_id);
 }
 
+std::vector<TrajectoryColumn> NanoWriteTrajectoriesSql::trajectory_columns = {
+    {.name = "step", .type = column_int32, .offset = offsetof(NanoWriteTrajectoriesSql, step)},
+    {.name = "time", .type = column_float64, .offset = offsetof(NanoWriteTrajectoriesSql, time)},
+    {.name = "site_id_1", .type = column_int32, .offset = offsetof(NanoWriteTrajectoriesSql, site_id_1)},
+    {.name = "site_id_2", .type = column_int32, .offset = offsetof(NanoWriteTrajectoriesSql, site_id_2)},
+    {.name = "interaction_id", .type = column_int32, .offset = offsetof(NanoWriteTrajectoriesSql, interaction_id)}};
+
 /* -------------------------- Read State SQL ---------------------------- */
 
 std::string NanoReadStateSql::sql_statement =
@@ -10,6 +10,9 @@ See the README file in the top-level RNMC directory.
 
 #include <sqlite3.h>
 #include <string>
+#include <vector>
+
+#include "../core/trajectory_file.h"
 
 #include "NPMC_types.h"
 
@@ -118,7 +121,8 @@ public:
     int site_id_2;
     int interaction_id;
     static std::string sql_statement;
-    static void action(NanoWriteTrajectoriesSql &r, sqlite3_stmt *stmt);
+    static void action(NanoWriteTrajectoriesSql &r, sqlite3_stmt *stmt, int first_parameter = 1);
+    static std::vector<TrajectoryColumn> trajectory_columns; // seed is stored per chunk
 };
 
 /* ----------------------------- I/O state SQL ----------------------- */
@@ -155,7 +159,8 @@ struct NanoStateHistoryElement
 struct NanoTrajectoryHistoryElement
 {
     unsigned long int seed; // seed
-    NanoReaction reaction;  // reaction which fired
+    int site_id[2];         // sites and interaction of the reaction which fired
+    int interaction_id;
     double time;            // time after reaction has occoured.
     int step;
 };
@@ -26,6 +26,34 @@ struct Cutoff
     TypeOfCutoff type_of_cutoff;
 };
 
+// sampling of the state of the simulations. if interval is positive,
+// the simulations record the counts of the species in species, or of
+// every species if it is empty, at the times 0, interval, 2 interval ...
+// up to end, and do not record the reactions which fire. a time is
+// sampled once the reaction after it has occurred, or once no more
+// reactions can occur. the reaction which takes a simulation past a
+// time cutoff is kept in its checkpoint, so a run resumed with a later
+// cutoff has no samples between the two cutoffs before that reaction.
+struct Sampling
+{
+    double interval;
+    double end; // infinite unless the run has a time cutoff
+    std::vector<int> species;
+};
+
+// number of species of a state, which is either a vector of counts or
+// holds one called homogeneous
+template <typename State>
+unsigned long int number_of_species(const State &state)
+{
+    return state.homogeneous.size();
+}
+
+inline unsigned long int number_of_species(const std::vector<int> &state)
+{
+    return state.size();
+}
+
 template <typename T>
 struct HistoryPacket
 {
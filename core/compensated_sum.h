@@ -0,0 +1,47 @@
+/* ----------------------------------------------------------------------
+RNMC - Reaction Network Monte Carlo
+https://blaugroup.github.io/RNMC/
+
+See the README file in the top-level RNMC directory.
+---------------------------------------------------------------------- */
+
+#ifndef RNMC_COMPENSATED_SUM_H
+#define RNMC_COMPENSATED_SUM_H
+
+#include <cmath>
+
+// running sum with Neumaier compensation. solvers keep their propensity
+// sum up to date by adding and subtracting propensities as they change,
+// and over millions of steps the rounding error of a plain double sum
+// can grow until the sum no longer matches the propensities, or even
+// becomes non positive. the compensation term collects the low order
+// bits which are lost in each addition, so the error stays at the order
+// of a single rounding however many updates are made.
+
+class CompensatedSum
+{
+private:
+    double sum;
+    double compensation;
+
+public:
+    CompensatedSum() : sum(0.0), compensation(0.0){};
+    CompensatedSum(double value) : sum(value), compensation(0.0){};
+
+    void add(double value)
+    {
+        double t = sum + value;
+        if (std::fabs(sum) >= std::fabs(value))
+            compensation += (sum - t) + value;
+        else
+            compensation += (value - t) + sum;
+        sum = t;
+    };
+
+    double get() const
+    {
+        return sum + compensation;
+    };
+};
+
+#endif
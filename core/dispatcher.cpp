@@ -37,7 +37,10 @@ Dispatcher<Solver, Model, Parameters, WriteTrajectoriesSql,
     unsigned long int base_seed,
     int number_of_threads,
     Cutoff cutoff,
-    Parameters parameters) : model_database(model_database_file,
+    Parameters parameters,
+    SqlWriteProfile write_profile,
+    std::string trajectory_file_path,
+    Sampling sampling) : model_database(model_database_file,
                                             SQLITE_OPEN_READWRITE),
                              initial_state_database(
                                  initial_state_database_file,
@@ -45,26 +48,105 @@ Dispatcher<Solver, Model, Parameters, WriteTrajectoriesSql,
                              model(model_database,
                                    initial_state_database,
                                    parameters),
-                             trajectories_stmt(initial_state_database),
-                             trajectories_writer(trajectories_stmt),
+                             write_profile(write_profile),
+                             trajectories_writer(initial_state_database),
+                             trajectory_file(),
+                             sampling(sampling),
+                             species_count_writer(),
                              state_stmt(initial_state_database),
                              state_writer(state_stmt),
                              cutoff_stmt(initial_state_database),
                              cutoff_writer(cutoff_stmt),
-                             history_queue(),
-                             state_history_queue(),
-                             cutoff_history_queue(),
-                             seed_queue(number_of_simulations, base_seed),
+                             packet_budget(packets_in_flight_per_simulator *
+                                           std::max(number_of_threads, 1)),
+                             writer_signal(),
+                             trajectory_row_queue(&writer_signal),
+                             trajectory_chunk_queue(&writer_signal),
+                             state_history_queue(&writer_signal),
+                             cutoff_history_queue(&writer_signal),
+                             species_count_queue(&writer_signal, &packet_budget),
+                             converter_signals(),
+                             history_queues(),
+                             // about 64 chunks per thread, so threads which draw
+                             // long simulations do not hold many unstarted seeds
+                             seed_queue(number_of_simulations, base_seed,
+                                        number_of_simulations / (64 * std::max(number_of_threads, 1))),
                              threads(), // don't want to start threads in the constructor.
-                             running(number_of_threads, false),
+                             converter_threads(),
+                             writer_thread(),
                              cutoff(cutoff),
                              number_of_simulations(number_of_simulations),
                              number_of_threads(number_of_threads),
+                             number_of_converters(
+                                 (std::max(number_of_threads, 1) + simulators_per_converter - 1) /
+                                 simulators_per_converter),
                              seed_state_map(),
                              seed_step_map(),
                              seed_time_map()
 {
 
+    for (int species_id : sampling.species)
+    {
+        if (species_id < 0 ||
+            static_cast<unsigned long int>(species_id) >= number_of_species(model.initial_state))
+        {
+            std::cerr << time::time_stamp()
+                      << "sampled species " << species_id
+                      << " is not in the reaction network\n";
+            std::abort();
+        }
+    }
+
+    if (!trajectory_file_path.empty())
+        trajectory_file = std::make_unique<TrajectoryFileWriter>(
+            trajectory_file_path, WriteTrajectoriesSql::trajectory_columns);
+
+    // each step of a trajectory is written once. the inserts into
+    // trajectories ignore rows whose (seed, step) is already there, for
+    // instance steps which were written after the checkpoint of an
+    // interrupted run and are simulated again when it resumes. a
+    // database written by an older version has no index and may already
+    // hold such duplicates, which are removed once before it is created.
+    if (!initial_state_database.has_rows(
+            "SELECT 1 FROM sqlite_master "
+            "WHERE type = 'index' AND name = 'trajectories_seed_step';"))
+    {
+        if (initial_state_database.has_rows(
+                "SELECT 1 FROM trajectories GROUP BY seed, step "
+                "HAVING COUNT(*) > 1 LIMIT 1;"))
+        {
+            std::cerr << time::time_stamp()
+                      << "removing duplicate trajectories...\n";
+
+            initial_state_database.exec(
+                "DELETE FROM trajectories WHERE rowid NOT IN"
+                "(SELECT MIN(rowid) FROM trajectories GROUP BY seed, step);");
+        }
+
+        initial_state_database.exec(
+            "CREATE UNIQUE INDEX trajectories_seed_step "
+            "ON trajectories (seed, step);");
+    }
+
+    if (sampling.interval > 0.0)
+    {
+        initial_state_database.exec(
+            "CREATE TABLE IF NOT EXISTS species_counts ("
+            "seed INTEGER NOT NULL, "
+            "time REAL NOT NULL, "
+            "species_id INTEGER NOT NULL, "
+            "count INTEGER NOT NULL);");
+
+        // as for trajectories, samples taken again by a resumed run are
+        // ignored
+        initial_state_database.exec(
+            "CREATE UNIQUE INDEX IF NOT EXISTS species_counts_seed_time_species "
+            "ON species_counts (seed, time, species_id);");
+
+        species_count_writer = std::make_unique<SqlMultiRowWriter<WriteSpeciesCountSql>>(
+            initial_state_database);
+    }
+
     SqlStatement<ReadStateSql> state_statement(initial_state_database);
     SqlReader<ReadStateSql> state_reader(state_statement);
 
@@ -74,20 +156,37 @@ Dispatcher<Solver, Model, Parameters, WriteTrajectoriesSql,
     SqlStatement<ReadTrajectoriesSql> trajectory_statement(initial_state_database);
     SqlReader<ReadTrajectoriesSql> trajectory_reader(trajectory_statement);
 
-    SeedQueue temp_seed_queue = SeedQueue(number_of_simulations,
-                                          base_seed);
-
     std::map<int, State> temp_seed_state_map;
     std::map<int, int> temp_seed_step_map;
     std::map<int, double> temp_seed_time_map;
 
     model.checkpoint(state_reader, cutoff_reader, trajectory_reader,
                      temp_seed_state_map, temp_seed_step_map,
-                     temp_seed_queue, temp_seed_time_map, model);
+                     temp_seed_time_map, model);
 
     seed_state_map = std::move(temp_seed_state_map);
     seed_step_map = temp_seed_step_map;
     seed_time_map = temp_seed_time_map;
+
+    // a simulation stops once it has gone past the cutoff, so seeds
+    // whose checkpoint is past the cutoff are already complete and are
+    // not run again
+    for (auto &[seed, step] : seed_step_map)
+    {
+        bool complete = false;
+        switch (cutoff.type_of_cutoff)
+        {
+        case step_termination:
+            complete = step > cutoff.bound.step;
+            break;
+        case time_termination:
+            complete = seed_time_map[seed] > cutoff.bound.time;
+            break;
+        }
+
+        if (complete)
+            seed_queue.exclude(seed);
+    }
 } // Dispatcher()
 
 /* ------------------------------------------------------------------- */
@@ -174,10 +273,25 @@ void Dispatcher<Solver, Model, Parameters, WriteTrajectoriesSql,
     // Set the masks so the child threads inherit the sigmask to ignore SIGTERM
     pthread_sigmask(SIG_BLOCK, &mask, NULL);
 
+    initial_state_database.apply_write_profile(write_profile);
+
+    // simulator thread i hands its trajectory packets to converter
+    // i % number_of_converters
+    for (int c = 0; c < number_of_converters; c++)
+    {
+        converter_signals.push_back(std::make_unique<HistorySignal>());
+        history_queues.push_back(
+            std::make_unique<HistoryQueue<HistoryPacket<TrajHistory>>>(
+                converter_signals[c].get(), &packet_budget));
+        converter_signals[c]->running_simulators.store(
+            (number_of_threads - c + number_of_converters - 1) / number_of_converters);
+    }
+    writer_signal.running_simulators.store(number_of_converters);
+
     threads.resize(number_of_threads);
     for (int i = 0; i < number_of_threads; i++)
     {
-        running[i] = true;
+        int c = i % number_of_converters;
         threads[i] = std::thread(
             [](SimulatorPayload<Solver, Model, StateHistory, TrajHistory,
                                 CutoffHistory, Sim, State>
@@ -186,16 +300,26 @@ void Dispatcher<Solver, Model, Parameters, WriteTrajectoriesSql,
             SimulatorPayload<Solver, Model, StateHistory, TrajHistory,
                              CutoffHistory, Sim, State>(
                 model,
-                history_queue,
+                *history_queues[c],
                 state_history_queue,
                 cutoff_history_queue,
+                species_count_queue,
                 seed_queue,
                 cutoff,
-                running.begin() + i,
+                sampling,
+                *converter_signals[c],
                 seed_state_map,
                 seed_step_map,
                 seed_time_map));
     }
+
+    for (int c = 0; c < number_of_converters; c++)
+        converter_threads.push_back(std::thread([this, c]()
+                                                { run_converter(c); }));
+
+    writer_thread = std::thread([this]()
+                                { run_writer(); });
+
     // Unset the sigmask so that the parent thread
     // resumes catching errors as normal
     pthread_sigmask(SIG_UNBLOCK, &mask, NULL);
@@ -206,69 +330,256 @@ void Dispatcher<Solver, Model, Parameters, WriteTrajectoriesSql,
     sigaction(SIGINT, &action, NULL);
     sigaction(SIGTERM, &action, NULL);
 
+    for (int i = 0; i < number_of_threads; i++)
+        threads[i].join();
+
+    for (int c = 0; c < number_of_converters; c++)
+        converter_threads[c].join();
+
+    writer_thread.join();
+
+    if (trajectory_file)
+        trajectory_file->close();
+
+    initial_state_database.restore_default_profile();
+
+} // run_dispatcher()
+
+/* ------------------------------------------------------------------- */
+
+template <
+    typename Solver,
+    typename Model,
+    typename Parameters,
+    typename WriteTrajectoriesSql,
+    typename ReadTrajectoriesSql,
+    typename WriteStateSql,
+    typename ReadStateSql,
+    typename WriteCutoffSql,
+    typename ReadCutoffSql,
+    typename StateHistory,
+    typename TrajHistory,
+    typename CutoffHistory,
+    typename Sim,
+    typename State>
+
+void Dispatcher<Solver, Model, Parameters, WriteTrajectoriesSql,
+                ReadTrajectoriesSql, WriteStateSql, ReadStateSql,
+                WriteCutoffSql, ReadCutoffSql, StateHistory, TrajHistory,
+                CutoffHistory, Sim, State>::run_converter(int converter)
+{
+
+    // turning history elements into rows is done here rather than on
+    // the writer thread, so the writer only spends its time in sqlite
+    HistorySignal &signal = *converter_signals[converter];
+    HistoryQueue<HistoryPacket<TrajHistory>> &history_queue = *history_queues[converter];
+
     bool finished = false;
     while (!finished)
     {
+        signal.wait(
+            [&]
+            {
+                return !history_queue.empty() ||
+                       signal.all_simulators_finished();
+            });
 
-        if (history_queue.empty())
-        {
+        // a simulator thread inserts all its packets before it finishes,
+        // so once this is true, draining the queue below converts
+        // everything that is left
+        finished = signal.all_simulators_finished();
 
-            bool all_simulations_finished = true;
+        while (std::optional<HistoryPacket<TrajHistory>>
+                   maybe_history_packet = history_queue.get_history())
+        {
+            HistoryPacket<TrajHistory> history_packet = std::move(maybe_history_packet.value());
 
-            for (bool flag : running)
+            std::vector<WriteTrajectoriesSql> rows;
+            rows.reserve(history_packet.history.size());
+            for (unsigned long int i = 0; i < history_packet.history.size(); i++)
             {
-                if (flag)
-                {
-                    all_simulations_finished = false;
-                    break;
-                }
+                rows.push_back(
+                    model.history_element_to_sql(
+                        (int)history_packet.seed,
+                        history_packet.history[i]));
             }
 
-            if (all_simulations_finished)
-                finished = true;
+            // frees the history of the simulator before the rows are queued
+            history_packet.history = std::vector<TrajHistory>();
+
+            if (trajectory_file)
+                trajectory_chunk_queue.insert_history(
+                    HistoryPacket<char>{
+                        .seed = history_packet.seed,
+                        .history = encode_trajectory_chunk(
+                            history_packet.seed, rows,
+                            WriteTrajectoriesSql::trajectory_columns,
+                            chunk_packed)});
+            else
+                trajectory_row_queue.insert_history(
+                    HistoryPacket<WriteTrajectoriesSql>{
+                        .seed = history_packet.seed,
+                        .history = std::move(rows)});
         }
+    }
 
-        std::optional<HistoryPacket<TrajHistory>>
-            maybe_history_packet = history_queue.get_history();
+    writer_signal.simulator_finished();
 
-        if (maybe_history_packet)
-        {
-            HistoryPacket<TrajHistory> history_packet = std::move(maybe_history_packet.value());
-            record_simulation_history(std::move(history_packet));
-        }
-        if (model.isCheckpoint)
+} // run_converter()
+
+/* ------------------------------------------------------------------- */
+
+template <
+    typename Solver,
+    typename Model,
+    typename Parameters,
+    typename WriteTrajectoriesSql,
+    typename ReadTrajectoriesSql,
+    typename WriteStateSql,
+    typename ReadStateSql,
+    typename WriteCutoffSql,
+    typename ReadCutoffSql,
+    typename StateHistory,
+    typename TrajHistory,
+    typename CutoffHistory,
+    typename Sim,
+    typename State>
+
+void Dispatcher<Solver, Model, Parameters, WriteTrajectoriesSql,
+                ReadTrajectoriesSql, WriteStateSql, ReadStateSql,
+                WriteCutoffSql, ReadCutoffSql, StateHistory, TrajHistory,
+                CutoffHistory, Sim, State>::run_writer()
+{
+
+    // rows per second are measured over the time spent in transactions,
+    // so they show how fast the database takes rows rather than how
+    // fast the simulations produce them
+    unsigned long int total_rows = 0;
+    unsigned long int total_species_counts = 0;
+    std::chrono::duration<double> write_time(0.0);
+
+    bool finished = false;
+    while (!finished)
+    {
+        // sleep until there is something to write or every converter
+        // thread is done
+        writer_signal.wait(
+            [&]
+            {
+                return !trajectory_row_queue.empty() ||
+                       !trajectory_chunk_queue.empty() ||
+                       !state_history_queue.empty() ||
+                       !cutoff_history_queue.empty() ||
+                       !species_count_queue.empty() ||
+                       writer_signal.all_simulators_finished();
+            });
+
+        // a converter finishes after all of its simulators, which insert
+        // their state and cutoff packets before they finish, so once
+        // this is true, draining the queues below writes everything
+        // that is left
+        finished = writer_signal.all_simulators_finished();
+
+        // group commit: everything which has arrived is written in a
+        // single transaction, committing early if it gets large so the
+        // packets are released to the simulator threads regularly
+        bool drained = false;
+        while (!drained)
         {
-            std::optional<HistoryPacket<StateHistory>>
-                maybe_state_history_packet = state_history_queue.get_history();
+            unsigned long int rows = 0;
+            unsigned long int species_counts = 0;
+            long int packets = 0;
+            auto start = std::chrono::steady_clock::now();
+
+            initial_state_database.exec("BEGIN;");
 
-            if (maybe_state_history_packet)
+            drained = true;
+            while (std::optional<HistoryPacket<WriteTrajectoriesSql>>
+                       maybe_row_packet = trajectory_row_queue.get_history())
             {
-                HistoryPacket<StateHistory> state_history_packet = std::move(maybe_state_history_packet.value());
-                record_state(std::move(state_history_packet));
+                HistoryPacket<WriteTrajectoriesSql> row_packet = std::move(maybe_row_packet.value());
+                rows += row_packet.history.size();
+                packets++;
+                record_simulation_history(std::move(row_packet));
+
+                if (rows >= group_commit_size)
+                {
+                    drained = false;
+                    break;
+                }
             }
 
-            std::optional<HistoryPacket<CutoffHistory>>
-                maybe_cutoff_history_packet = cutoff_history_queue.get_history();
+            while (std::optional<HistoryPacket<char>>
+                       maybe_chunk_packet = trajectory_chunk_queue.get_history())
+            {
+                HistoryPacket<char> chunk_packet = std::move(maybe_chunk_packet.value());
+                TrajectoryChunkHeader header;
+                std::memcpy(&header, chunk_packet.history.data(), sizeof(TrajectoryChunkHeader));
+                rows += header.number_of_rows;
+                packets++;
+                trajectory_file->append(chunk_packet.history);
+
+                if (rows >= group_commit_size)
+                {
+                    drained = false;
+                    break;
+                }
+            }
 
-            if (maybe_cutoff_history_packet)
+            while (std::optional<HistoryPacket<SpeciesCountHistoryElement>>
+                       maybe_species_count_packet = species_count_queue.get_history())
             {
-                HistoryPacket<CutoffHistory> cutoff_history_packet = std::move(maybe_cutoff_history_packet.value());
-                record_cutoff(std::move(cutoff_history_packet));
+                HistoryPacket<SpeciesCountHistoryElement> species_count_packet =
+                    std::move(maybe_species_count_packet.value());
+                species_counts += species_count_packet.history.size();
+                packets++;
+                record_species_counts(std::move(species_count_packet));
+
+                if (rows + species_counts >= group_commit_size)
+                {
+                    drained = false;
+                    break;
+                }
             }
-        }
-    }
 
-    for (int i = 0; i < number_of_threads; i++)
-        threads[i].join();
+            if (model.isCheckpoint)
+            {
+                while (std::optional<HistoryPacket<StateHistory>>
+                           maybe_state_history_packet = state_history_queue.get_history())
+                {
+                    HistoryPacket<StateHistory> state_history_packet = std::move(maybe_state_history_packet.value());
+                    record_state(std::move(state_history_packet));
+                }
 
-    initial_state_database.exec(
-        "DELETE FROM trajectories WHERE rowid NOT IN"
-        "(SELECT MIN(rowid) FROM trajectories GROUP BY seed, step);");
+                while (std::optional<HistoryPacket<CutoffHistory>>
+                           maybe_cutoff_history_packet = cutoff_history_queue.get_history())
+                {
+                    HistoryPacket<CutoffHistory> cutoff_history_packet = std::move(maybe_cutoff_history_packet.value());
+                    record_cutoff(std::move(cutoff_history_packet));
+                }
+            }
+
+            initial_state_database.exec("COMMIT;");
+            if (trajectory_file)
+                trajectory_file->flush();
+
+            write_time += std::chrono::steady_clock::now() - start;
+            total_rows += rows;
+            total_species_counts += species_counts;
+            packet_budget.release(packets);
+        }
+    }
 
     std::cerr << time::time_stamp()
-              << "removing duplicate trajectories...\n";
+              << "wrote " << total_rows << " trajectory rows, "
+              << (write_time.count() > 0.0 ? total_rows / write_time.count() : 0.0)
+              << " rows/s\n";
 
-} // run_dispatcher()
+    if (species_count_writer)
+        std::cerr << time::time_stamp()
+                  << "wrote " << total_species_counts << " species counts\n";
+
+} // run_writer()
 
 /* ------------------------------------------------------------------- */
 
@@ -291,26 +602,17 @@ template <
 void Dispatcher<Solver, Model, Parameters, WriteTrajectoriesSql,
                 ReadTrajectoriesSql, WriteStateSql, ReadStateSql,
                 WriteCutoffSql, ReadCutoffSql, StateHistory, TrajHistory,
-                CutoffHistory, Sim, State>::record_simulation_history(HistoryPacket<TrajHistory> history_packet)
+                CutoffHistory, Sim, State>::record_simulation_history(HistoryPacket<WriteTrajectoriesSql> row_packet)
 {
 
-    initial_state_database.exec("BEGIN;");
-
-    for (unsigned long int i = 0; i < history_packet.history.size(); i++)
-    {
-        trajectories_writer.insert(
-            model.history_element_to_sql(
-                (int)history_packet.seed,
-                history_packet.history[i]));
-    }
-
-    initial_state_database.exec("COMMIT;");
+    // called by the writer thread inside its transaction
+    trajectories_writer.insert(row_packet.history);
 
     // std::cerr << time::time_stamp()
     //           << "wrote "
-    //           << history_packet.history.size()
+    //           << row_packet.history.size()
     //           << " events from trajectory "
-    //           << history_packet.seed
+    //           << row_packet.seed
     //           << " to database\n";
 
 } // record_simulation_history()
@@ -344,7 +646,6 @@ void Dispatcher<Solver, Model, Parameters, WriteTrajectoriesSql,
 
     initial_state_database.exec(delete_statement);
 
-    initial_state_database.exec("BEGIN;");
 
     for (unsigned long int i = 0; i < state_history_packet.history.size(); i++)
     {
@@ -353,7 +654,6 @@ void Dispatcher<Solver, Model, Parameters, WriteTrajectoriesSql,
                 (int)state_history_packet.seed,
                 state_history_packet.history[i]));
     }
-    initial_state_database.exec("COMMIT;");
 
     // std::cerr << time::time_stamp()
     //           << "wrote "
@@ -393,7 +693,6 @@ void Dispatcher<Solver, Model, Parameters, WriteTrajectoriesSql,
 
     initial_state_database.exec(delete_statement);
 
-    initial_state_database.exec("BEGIN;");
 
     for (unsigned long int i = 0; i < cutoff_history_packet.history.size(); i++)
     {
@@ -402,7 +701,6 @@ void Dispatcher<Solver, Model, Parameters, WriteTrajectoriesSql,
                 (int)cutoff_history_packet.seed,
                 cutoff_history_packet.history[i]));
     }
-    initial_state_database.exec("COMMIT;");
 
     // std::cerr << time::time_stamp()
     //           << "wrote cutoff for trajectory "
@@ -413,6 +711,46 @@ void Dispatcher<Solver, Model, Parameters, WriteTrajectoriesSql,
 
 /* ------------------------------------------------------------------- */
 
+template <
+    typename Solver,
+    typename Model,
+    typename Parameters,
+    typename WriteTrajectoriesSql,
+    typename ReadTrajectoriesSql,
+    typename WriteStateSql,
+    typename ReadStateSql,
+    typename WriteCutoffSql,
+    typename ReadCutoffSql,
+    typename StateHistory,
+    typename TrajHistory,
+    typename CutoffHistory,
+    typename Sim,
+    typename State>
+
+void Dispatcher<Solver, Model, Parameters, WriteTrajectoriesSql,
+                ReadTrajectoriesSql, WriteStateSql, ReadStateSql,
+                WriteCutoffSql, ReadCutoffSql, StateHistory, TrajHistory,
+                CutoffHistory, Sim, State>::record_species_counts(HistoryPacket<SpeciesCountHistoryElement> species_count_packet)
+{
+
+    // called by the writer thread inside its transaction
+    std::vector<WriteSpeciesCountSql> rows;
+    rows.reserve(species_count_packet.history.size());
+    for (SpeciesCountHistoryElement &species_count : species_count_packet.history)
+    {
+        rows.push_back(WriteSpeciesCountSql{
+            .seed = (int)species_count_packet.seed,
+            .time = species_count.time,
+            .species_id = species_count.species_id,
+            .count = species_count.count});
+    }
+
+    species_count_writer->insert(rows);
+
+} // record_species_counts()
+
+/* ------------------------------------------------------------------- */
+
 template <
     typename Solver,
     typename Model,
@@ -10,18 +10,37 @@ See the README file in the top-level RNMC directory.
 
 #include <mutex>
 #include <thread>
+#include <chrono>
 #include <csignal>
 #include <iostream>
 #include <string>
 #include <map>
 #include <vector>
+#include <memory>
+#include <limits>
 
 #include "sql.h"
 #include "queues.h"
+#include "trajectory_file.h"
 #include "RNMC_types.h"
 #include "simulation.h"
 #include "simulator_payload.h"
 
+/* ----------------------------------------------------------------------
+    output pipeline. the simulator threads hand their history packets to
+    converter threads, which turn them into rows for the database, and a
+    single writer thread writes the rows with one transaction per group
+    of packets. each converter serves simulators_per_converter simulator
+    threads. at most packets_in_flight_per_simulator packets per
+    simulator thread may be waiting to be written before the simulator
+    threads block, and a transaction is committed once it holds
+    group_commit_size rows or the queues are empty.
+---------------------------------------------------------------------- */
+
+constexpr int simulators_per_converter = 4;
+constexpr int packets_in_flight_per_simulator = 4;
+constexpr unsigned long int group_commit_size = 200000;
+
 template <
     typename Solver,
     typename Model,
@@ -45,8 +64,15 @@ public:
     SqlConnection model_database;
     SqlConnection initial_state_database;
     Model model;
-    SqlStatement<WriteTrajectoriesSql> trajectories_stmt;
-    SqlWriter<WriteTrajectoriesSql> trajectories_writer;
+    SqlWriteProfile write_profile;
+    SqlMultiRowWriter<WriteTrajectoriesSql> trajectories_writer;
+    // if set, trajectories are written to this file instead of the
+    // trajectories table
+    std::unique_ptr<TrajectoryFileWriter> trajectory_file;
+    // if the state is sampled, the samples are written to the
+    // species_counts table instead of the reactions to trajectories
+    Sampling sampling;
+    std::unique_ptr<SqlMultiRowWriter<WriteSpeciesCountSql>> species_count_writer;
 
     SqlStatement<WriteStateSql> state_stmt;
     SqlWriter<WriteStateSql> state_writer;
@@ -54,18 +80,34 @@ public:
     SqlStatement<WriteCutoffSql> cutoff_stmt;
     SqlWriter<WriteCutoffSql> cutoff_writer;
 
-    HistoryQueue<HistoryPacket<TrajHistory>> history_queue;
+    // trajectory packets go from the simulator threads to a converter
+    // through the queue of that converter, and from the converters to
+    // the writer as rows, or as chunks of the trajectory file. state and
+    // cutoff packets, and the species counts of sampled runs, go to the
+    // writer directly. the writer counts the converters as its
+    // producers.
+    PacketBudget packet_budget;
+    HistorySignal writer_signal; // must be constructed before the queues
+    HistoryQueue<HistoryPacket<WriteTrajectoriesSql>> trajectory_row_queue;
+    HistoryQueue<HistoryPacket<char>> trajectory_chunk_queue;
     HistoryQueue<HistoryPacket<StateHistory>> state_history_queue;
     HistoryQueue<HistoryPacket<CutoffHistory>> cutoff_history_queue;
+    HistoryQueue<HistoryPacket<SpeciesCountHistoryElement>> species_count_queue;
+    std::vector<std::unique_ptr<HistorySignal>> converter_signals;
+    std::vector<std::unique_ptr<HistoryQueue<HistoryPacket<TrajHistory>>>> history_queues;
 
     SeedQueue seed_queue;
     std::vector<std::thread> threads;
-    std::vector<bool> running;
+    std::vector<std::thread> converter_threads;
+    std::thread writer_thread;
     Cutoff cutoff;
     TypeOfCutoff type_of_cutoff;
     int number_of_simulations;
     int number_of_threads;
+    int number_of_converters;
     struct sigaction action;
+    // start of the seeds with a checkpoint, the other seeds start from
+    // the initial state of the model at step 0 and time 0
     std::map<int, State> seed_state_map;
     std::map<int, int> seed_step_map;
     std::map<int, double> seed_time_map;
@@ -77,13 +119,25 @@ public:
         unsigned long int base_seed,
         int number_of_threads,
         Cutoff cutoff,
-        Parameters parameters);
+        Parameters parameters,
+        SqlWriteProfile write_profile = SqlWriteProfile{
+            .synchronous = "NORMAL",
+            .cache_size_mib = default_cache_size_mib,
+            .mmap_size_mib = default_mmap_size_mib},
+        std::string trajectory_file_path = "",
+        Sampling sampling = Sampling{
+            .interval = 0.0,
+            .end = std::numeric_limits<double>::infinity(),
+            .species = {}});
 
     void static signalHandler(int signum);
     void run_dispatcher();
-    void record_simulation_history(HistoryPacket<TrajHistory> traj_history_packet);
+    void run_converter(int converter);
+    void run_writer();
+    void record_simulation_history(HistoryPacket<WriteTrajectoriesSql> trajectory_row_packet);
     void record_state(HistoryPacket<StateHistory> state_history_packet);
     void record_cutoff(HistoryPacket<CutoffHistory> cutoff_history_packet);
+    void record_species_counts(HistoryPacket<SpeciesCountHistoryElement> species_count_packet);
     void static write_error_message(std::string s);
 };
 
@@ -12,10 +12,10 @@ void EnergyReactionNetworkSimulation<Solver>::init()
 {
     std::vector<double> initial_propensities_temp;
 
-    energy_reaction_network.compute_initial_propensities(state.homogeneous, initial_propensities_temp);
+    energy_reaction_network.compute_initial_energy_propensities(state.homogeneous,
+                                                                state.energy_budget,
+                                                                initial_propensities_temp);
     solver = Solver(this->seed, std::ref(initial_propensities_temp));
-    this->update_function = [&](Update update)
-    { solver.update(update); };
 } // init()
 
 /* ------------------------------------------------------------------- */
@@ -27,6 +27,8 @@ bool EnergyReactionNetworkSimulation<Solver>::execute_step()
 
     if (!maybe_event)
     {
+        if (this->sampling)
+            this->finish_sampling(state.homogeneous);
 
         return false;
     }
@@ -39,23 +41,29 @@ bool EnergyReactionNetworkSimulation<Solver>::execute_step()
         // update time
         this->time += event.dt;
 
-        // record what happened
-        history.push_back(ReactionNetworkTrajectoryHistoryElement{
-            .seed = this->seed,
-            .reaction_id = next_reaction,
-            .time = this->time,
-            .step = this->step});
-
-        if (history.size() == this->history_chunk_size)
+        // record what happened, or only the state at the sample times
+        // which passed before it
+        if (this->sampling)
+            this->sample_state(state.homogeneous, this->time);
+        else
         {
-            history_queue.insert_history(
-                std::move(
-                    HistoryPacket<ReactionNetworkTrajectoryHistoryElement>{
-                        .seed = this->seed,
-                        .history = std::move(this->history)}));
-
-            history = std::vector<ReactionNetworkTrajectoryHistoryElement>();
-            history.reserve(this->history_chunk_size);
+            history.push_back(ReactionNetworkTrajectoryHistoryElement{
+                .seed = this->seed,
+                .reaction_id = next_reaction,
+                .time = this->time,
+                .step = this->step});
+
+            if (history.size() == this->history_chunk_size)
+            {
+                history_queue.insert_history(
+                    std::move(
+                        HistoryPacket<ReactionNetworkTrajectoryHistoryElement>{
+                            .seed = this->seed,
+                            .history = std::move(this->history)}));
+
+                history = std::vector<ReactionNetworkTrajectoryHistoryElement>();
+                history.reserve(this->history_chunk_size);
+            }
         }
 
         // increment step
@@ -64,14 +72,16 @@ bool EnergyReactionNetworkSimulation<Solver>::execute_step()
         // update state
         energy_reaction_network.update_state(std::ref(state.homogeneous), next_reaction);
 
-        // update propensities
+        // update energy budget
+        double previous_energy_budget = state.energy_budget;
         energy_reaction_network.update_energy_budget(std::ref(state.energy_budget), next_reaction);
 
         // update propensities
         energy_reaction_network.update_propensities(
-            this->update_function,
+            solver,
             std::ref(state.homogeneous),
             next_reaction,
+            previous_energy_budget,
             state.energy_budget);
 
         return true;
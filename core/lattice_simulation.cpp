@@ -15,17 +15,11 @@ void LatticeSimulation::init()
     lattice_network.compute_initial_propensities(state.homogeneous, state.lattice, temp_initial_props);
 
     latSolver = LatticeSolver(seed, std::ref(temp_initial_props));
-    this->update_function = [&](Update update)
-    { latSolver.update(update); };
-    lattice_update_function = [&](LatticeUpdate lattice_update,
-                                  std::unordered_map<std::string,
-                                                     std::vector<std::pair<double, int>>> &props)
-    { latSolver.update(lattice_update, props); };
 
     lattice_network.update_adsorp_state(state.lattice, this->props,
                                         latSolver.propensity_sum,
                                         latSolver.number_of_active_indices);
-    lattice_network.update_adsorp_props(state.lattice, lattice_update_function,
+    lattice_network.update_adsorp_props(state.lattice, latSolver,
                                         state.homogeneous, std::ref(props));
 
     // only call if checkpointing
@@ -34,7 +28,7 @@ void LatticeSimulation::init()
         lattice_network.update_all_propensities(state.lattice, props,
                                                 latSolver.propensity_sum,
                                                 latSolver.number_of_active_indices,
-                                                lattice_update_function);
+                                                latSolver);
     }
 } // init()
 
@@ -148,8 +142,7 @@ bool LatticeSimulation::execute_step()
         // update_propensities
         lattice_network.update_propensities(state.lattice,
                                             std::ref(this->state.homogeneous),
-                                            this->update_function, lattice_update_function,
-                                            next_reaction, event.site_one, event.site_two, props);
+                                            latSolver, next_reaction, event.site_one, event.site_two, props);
 
         // increment step
         this->step++;
@@ -20,15 +20,10 @@ See the README file in the top-level RNMC directory.
 class LatticeSimulation : public Simulation<LatticeSolver>
 {
 public:
-    std::unordered_map<std::string, std::vector<std::pair<double, int>>> props;
+    LatticePropensityTable props;
     LatticeSolver latSolver;
     LatticeReactionNetwork &lattice_network;
     LatticeState state;
-    std::function<void(LatticeUpdate, std::unordered_map<std::string,
-                                                         std::vector<std::pair<double, int>>> &)>
-        lattice_update_function;
-
-    std::function<void(Update)> update_function;
     std::vector<LatticeTrajectoryHistoryElement> history;
     HistoryQueue<HistoryPacket<LatticeTrajectoryHistoryElement>> &history_queue;
 
@@ -9,13 +9,21 @@ See the README file in the top-level RNMC directory.
 
 void NanoParticleSimulation::init()
 {
-    std::vector<std::set<int>> seed_site_reaction_dependency;
-    std::vector<NanoReaction> seed_reactions;
+    // seeds starting from the initial state copy the reactions the
+    // model computed up front, only seeds restored from a checkpoint
+    // need to compute their own
+    if (state == nano_particle.initial_state)
+    {
+        nanoSolver = NanoSolver(this->seed, std::ref(nano_particle.initial_reactions));
+        site_reaction_dependency = nano_particle.site_reaction_dependency;
+    }
+    else
+    {
+        std::vector<NanoReaction> seed_reactions;
 
-    seed_site_reaction_dependency.resize(nano_particle.sites.size());
-    nano_particle.compute_reactions(state, std::ref(seed_reactions), std::ref(seed_site_reaction_dependency));
-    nanoSolver = NanoSolver(this->seed, std::ref(seed_reactions));
-    site_reaction_dependency = seed_site_reaction_dependency;
+        nano_particle.compute_reactions(state, std::ref(seed_reactions), std::ref(site_reaction_dependency));
+        nanoSolver = NanoSolver(this->seed, std::move(seed_reactions));
+    }
 } // init()
 
 /* ------------------------------------------------------------------- */
@@ -42,7 +50,8 @@ bool NanoParticleSimulation::execute_step()
         // record what happened
         history.push_back(NanoTrajectoryHistoryElement{
             .seed = this->seed,
-            .reaction = next_reaction,
+            .site_id = {next_reaction.site_id[0], next_reaction.site_id[1]},
+            .interaction_id = next_reaction.interaction_id,
             .time = this->time,
             .step = this->step});
 
@@ -64,10 +73,13 @@ bool NanoParticleSimulation::execute_step()
         nano_particle.update_state(std::ref(state), next_reaction);
 
         // update list of current available reactions
+        changed_reactions.clear();
         nano_particle.update_reactions(std::cref(state), next_reaction,
                                        std::ref(site_reaction_dependency),
-                                       std::ref(nanoSolver.current_reactions));
-        nanoSolver.update();
+                                       std::ref(nanoSolver.current_reactions),
+                                       std::ref(changed_reactions),
+                                       std::ref(reaction_scratch));
+        nanoSolver.update(changed_reactions);
 
         return true;
     }
@@ -23,7 +23,9 @@ public:
     NanoParticle &nano_particle;
     std::vector<int> state;
     NanoSolver nanoSolver;
-    std::vector<std::set<int>> site_reaction_dependency;
+    SiteReactionLists site_reaction_dependency;
+    std::vector<int> changed_reactions; // reused every step
+    NanoReactionScratch reaction_scratch;
     std::vector<NanoTrajectoryHistoryElement> history;
     HistoryQueue<HistoryPacket<NanoTrajectoryHistoryElement>> &history_queue;
 
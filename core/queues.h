@@ -8,38 +8,199 @@ See the README file in the top-level RNMC directory.
 #ifndef RNMC_QUEUES_H
 #define RNMC_QUEUES_H
 
-#include <queue>
+#include <set>
+#include <algorithm>
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <optional>
 
+// seeds claimed by a single simulator thread which it has not run yet
+struct SeedChunk
+{
+    unsigned long int next;
+    unsigned long int end;
+};
+
+// hands out the seeds base_seed ... base_seed + number_of_seeds - 1.
+// the offset of the next unclaimed seed is an atomic counter, so getting
+// a seed never takes a lock and the queue uses O(1) memory however many
+// simulations are run. a thread passing a SeedChunk claims chunk_size
+// consecutive seeds at a time and only touches the counter once per
+// chunk. seeds in the exclusion set, for instance those whose checkpoint
+// shows they already reached the cutoff, are skipped. the exclusion set
+// must be filled before any seed is handed out.
 struct SeedQueue
 {
-    std::queue<unsigned long int> seeds;
+    const unsigned long int base_seed;
+    const unsigned long int number_of_seeds;
+    const unsigned long int chunk_size;
+    std::atomic<unsigned long int> next_offset;
+    std::set<unsigned long int> excluded;
+
+    SeedQueue(unsigned long int number_of_seeds,
+              unsigned long int base_seed,
+              unsigned long int chunk_size = 1) : base_seed(base_seed),
+                                                  number_of_seeds(number_of_seeds),
+                                                  chunk_size(chunk_size > 0 ? chunk_size : 1),
+                                                  next_offset(0) {}
+
+    void exclude(unsigned long int seed)
+    {
+        excluded.insert(seed);
+    }
+
+    bool is_excluded(unsigned long int seed) const
+    {
+        return !excluded.empty() && excluded.count(seed) > 0;
+    }
+
+    std::optional<unsigned long int> get_seed()
+    {
+        while (true)
+        {
+            unsigned long int offset = next_offset.fetch_add(1);
+            if (offset >= number_of_seeds)
+                return std::optional<unsigned long int>();
+
+            if (!is_excluded(base_seed + offset))
+                return std::optional<unsigned long int>(base_seed + offset);
+        }
+    }
+
+    // next seed of chunk, claiming a new chunk when it is used up
+    std::optional<unsigned long int> get_seed(SeedChunk &chunk)
+    {
+        while (true)
+        {
+            while (chunk.next < chunk.end)
+            {
+                unsigned long int seed = chunk.next++;
+                if (!is_excluded(seed))
+                    return std::optional<unsigned long int>(seed);
+            }
+
+            unsigned long int offset = next_offset.fetch_add(chunk_size);
+            if (offset >= number_of_seeds)
+                return std::optional<unsigned long int>();
+
+            chunk.next = base_seed + offset;
+            chunk.end = base_seed + std::min(offset + chunk_size, number_of_seeds);
+        }
+    }
+};
+
+/* ------------------------------------------------------------------- */
+
+// wakes the consumer of a set of history queues, one of the converter
+// threads or the writer thread of the dispatcher, when a packet is
+// inserted into one of them or when one of its producers finishes. the
+// consumer sleeps on the condition variable instead of polling the
+// queues, and producers only touch the mutex when the consumer is
+// actually asleep, so inserting a packet stays lock free in the common
+// case. running_simulators counts the producers which have not finished.
+struct HistorySignal
+{
     std::mutex mutex;
+    std::condition_variable condition;
+    std::atomic<bool> waiting;
+    std::atomic<int> running_simulators;
+
+    HistorySignal() : waiting(false), running_simulators(0) {}
 
-    SeedQueue(unsigned long int number_of_seeds, unsigned long int base_seed)
+    void notify()
     {
-        for (unsigned long int i = base_seed;
-             i < number_of_seeds + base_seed;
-             i++)
+        // the producer has already published its packet. if the
+        // dispatcher is not waiting yet, it will see the packet when it
+        // checks its predicate. otherwise taking the mutex makes sure it
+        // is blocked in wait() before we wake it.
+        if (waiting.load())
         {
-            seeds.push(i);
+            std::lock_guard<std::mutex> lock(mutex);
+            condition.notify_one();
         }
     }
 
-    std::optional<unsigned long int> get_seed()
+    void simulator_finished()
     {
-        std::lock_guard<std::mutex> lock(mutex);
+        running_simulators.fetch_sub(1);
+        notify();
+    }
 
-        if (seeds.empty())
+    bool all_simulators_finished()
+    {
+        return running_simulators.load() == 0;
+    }
+
+    // block until ready() returns true. ready() is checked after
+    // waiting is set, so a packet inserted concurrently is either
+    // seen by ready() or its producer sees waiting and wakes us.
+    template <typename Predicate>
+    void wait(Predicate ready)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        waiting.store(true);
+        condition.wait(lock, ready);
+        waiting.store(false);
+    }
+};
+
+/* ------------------------------------------------------------------- */
+
+// bounds the number of history packets which have been inserted by the
+// simulator threads but not yet written to the database. a simulator
+// thread inserting a packet while limit packets are in flight blocks
+// until the writer releases some, so when the simulations produce
+// history faster than it can be written the memory held by the queues
+// stays bounded instead of growing until the run is killed. like
+// HistorySignal, the mutex is only taken when a thread is blocked.
+struct PacketBudget
+{
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::atomic<int> waiting;
+    std::atomic<long int> in_flight;
+    const long int limit;
+
+    PacketBudget(long int limit) : waiting(0),
+                                   in_flight(0),
+                                   limit(limit > 0 ? limit : 1) {}
+
+    bool try_acquire()
+    {
+        long int n = in_flight.load();
+        while (n < limit)
         {
-            return std::optional<unsigned long int>();
+            if (in_flight.compare_exchange_weak(n, n + 1))
+                return true;
         }
-        else
+        return false;
+    }
+
+    void acquire()
+    {
+        if (try_acquire())
+            return;
+
+        // in_flight is checked after waiting is incremented, so a
+        // concurrent release is either seen here or sees us waiting
+        std::unique_lock<std::mutex> lock(mutex);
+        waiting.fetch_add(1);
+        condition.wait(lock, [&]
+                       { return try_acquire(); });
+        waiting.fetch_sub(1);
+    }
+
+    void release(long int packets)
+    {
+        if (packets == 0)
+            return;
+
+        in_flight.fetch_sub(packets);
+        if (waiting.load() > 0)
         {
-            unsigned long int result = seeds.front();
-            seeds.pop();
-            return std::optional<unsigned long int>(result);
+            std::lock_guard<std::mutex> lock(mutex);
+            condition.notify_all();
         }
     }
 };
@@ -64,32 +225,86 @@ struct HistoryQueue
     // to exactly the same memory as the vector which is used to write
     // to the initial state database, and every time a move is
     // supposed to happen, the old reference is actually zerod out).
-    std::queue<T> history_packets;
-    std::mutex mutex;
 
+    // the queue is a lock free multi producer single consumer linked
+    // list (after D. Vyukov's MPSC node queue). producers swap their node
+    // into head and then link the previous head to it, the consumer
+    // follows next pointers from tail, which always points at a node
+    // whose packet has already been taken. a producer which has swapped
+    // head but not yet linked its node makes the queue look empty for a
+    // moment, it notifies the signal once the node is linked. all the
+    // atomics use sequentially consistent ordering, which HistorySignal
+    // relies on so that either the dispatcher sees a new packet or the
+    // producer sees that the dispatcher is waiting.
+    struct Node
+    {
+        std::atomic<Node *> next;
+        std::optional<T> history_packet;
+    };
+
+    std::atomic<Node *> head; // most recently inserted node, producers only
+    Node *tail;               // consumer only
+    HistorySignal *signal;
+    PacketBudget *budget; // if set, a packet is acquired before each insert
+
+    HistoryQueue() : HistoryQueue(nullptr) {}
+
+    HistoryQueue(HistorySignal *signal,
+                 PacketBudget *budget = nullptr) : signal(signal),
+                                                   budget(budget)
+    {
+        Node *stub = new Node{.next = {nullptr}, .history_packet = {}};
+        head.store(stub);
+        tail = stub;
+    }
+
+    HistoryQueue(const HistoryQueue &) = delete;
+    HistoryQueue &operator=(const HistoryQueue &) = delete;
+
+    ~HistoryQueue()
+    {
+        while (tail)
+        {
+            Node *next = tail->next.load();
+            delete tail;
+            tail = next;
+        }
+    }
+
+    // only the consumer may call empty() and get_history()
     bool empty()
     {
-        std::lock_guard<std::mutex> lock(mutex);
-        return history_packets.empty();
+        return tail->next.load() == nullptr;
     }
 
     void insert_history(T history_packet)
     {
-        std::lock_guard<std::mutex> lock(mutex);
-        history_packets.push(std::move(history_packet));
+        if (budget)
+            budget->acquire();
+
+        Node *node = new Node{.next = {nullptr},
+                              .history_packet = std::optional<T>(std::move(history_packet))};
+
+        Node *previous = head.exchange(node);
+        previous->next.store(node);
+
+        if (signal)
+            signal->notify();
     }
 
     std::optional<T> get_history()
     {
-        std::lock_guard<std::mutex> lock(mutex);
-        if (history_packets.empty())
+        Node *next = tail->next.load();
+        if (next == nullptr)
         {
             return std::optional<T>();
         }
         else
         {
-            T result = std::move(history_packets.front());
-            history_packets.pop();
+            T result = std::move(next->history_packet.value());
+            next->history_packet.reset();
+            delete tail;
+            tail = next;
             return std::optional<T>(std::move(result));
         }
     };
@@ -14,8 +14,6 @@ void ReactionNetworkSimulation<Solver>::init()
     std::vector<double> initial_propensities_temp;
     reaction_network.compute_initial_propensities(state, initial_propensities_temp);
     solver = Solver(this->seed, std::ref(initial_propensities_temp));
-    this->update_function = [&](Update update)
-    { solver.update(update); };
 
 } // init()
 
@@ -28,6 +26,8 @@ bool ReactionNetworkSimulation<Solver>::execute_step()
 
     if (!maybe_event)
     {
+        if (this->sampling)
+            this->finish_sampling(state);
 
         return false;
     }
@@ -40,23 +40,29 @@ bool ReactionNetworkSimulation<Solver>::execute_step()
         // update time
         this->time += event.dt;
 
-        // record what happened
-        history.push_back(ReactionNetworkTrajectoryHistoryElement{
-            .seed = this->seed,
-            .reaction_id = next_reaction,
-            .time = this->time,
-            .step = this->step});
-
-        if (history.size() == this->history_chunk_size)
+        // record what happened, or only the state at the sample times
+        // which passed before it
+        if (this->sampling)
+            this->sample_state(state, this->time);
+        else
         {
-            history_queue.insert_history(
-                std::move(
-                    HistoryPacket<ReactionNetworkTrajectoryHistoryElement>{
-                        .seed = this->seed,
-                        .history = std::move(this->history)}));
-
-            history = std::vector<ReactionNetworkTrajectoryHistoryElement>();
-            history.reserve(this->history_chunk_size);
+            history.push_back(ReactionNetworkTrajectoryHistoryElement{
+                .seed = this->seed,
+                .reaction_id = next_reaction,
+                .time = this->time,
+                .step = this->step});
+
+            if (history.size() == this->history_chunk_size)
+            {
+                history_queue.insert_history(
+                    std::move(
+                        HistoryPacket<ReactionNetworkTrajectoryHistoryElement>{
+                            .seed = this->seed,
+                            .history = std::move(this->history)}));
+
+                history = std::vector<ReactionNetworkTrajectoryHistoryElement>();
+                history.reserve(this->history_chunk_size);
+            }
         }
 
         // increment step
@@ -67,7 +73,8 @@ bool ReactionNetworkSimulation<Solver>::execute_step()
 
         // update propensities
         reaction_network.update_propensities(
-            this->update_function,
+            solver,
+            updates,
             std::ref(state),
             next_reaction);
 
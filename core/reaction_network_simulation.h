@@ -20,6 +20,7 @@ private:
 public:
     GillespieReactionNetwork &reaction_network;
     std::vector<int> state;
+    std::vector<Update> updates; // reused every step
     std::vector<ReactionNetworkTrajectoryHistoryElement> history;
     HistoryQueue<HistoryPacket<ReactionNetworkTrajectoryHistoryElement>> &history_queue;
 
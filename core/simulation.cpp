@@ -6,6 +6,7 @@ See the README file in the top-level RNMC directory.
 ---------------------------------------------------------------------- */
 
 #include <string>
+#include <cmath>
 
 #include "simulation.h"
 
@@ -64,4 +65,87 @@ void Simulation<Solver>::write_error_message(std::string s)
     strcpy(char_array, s.c_str());
 
     write(STDERR_FILENO, char_array, sizeof(char_array) - 1);
-} // write_error_message()
\ No newline at end of file
+} // write_error_message()
+
+/* ------------------------------------------------------------------- */
+
+template <typename Solver>
+void Simulation<Solver>::start_sampling(const Sampling &sampling,
+                                        HistoryQueue<HistoryPacket<SpeciesCountHistoryElement>> &species_count_queue)
+{
+    this->sampling = &sampling;
+    this->species_count_queue = &species_count_queue;
+    species_counts.reserve(history_chunk_size);
+
+    // a simulation resumed from a checkpoint has already sampled the
+    // times before the one it starts at
+    next_sample = std::ceil(time / sampling.interval);
+    while (next_sample > 0 && (next_sample - 1) * sampling.interval >= time)
+        next_sample--;
+    while (next_sample * sampling.interval < time)
+        next_sample++;
+} // start_sampling()
+
+/* ------------------------------------------------------------------- */
+
+template <typename Solver>
+void Simulation<Solver>::record_sample(const std::vector<int> &state)
+{
+    double sample_time = next_sample * sampling->interval;
+    next_sample++;
+
+    auto sample = [&](int species_id)
+    {
+        species_counts.push_back(SpeciesCountHistoryElement{
+            .seed = seed,
+            .time = sample_time,
+            .species_id = species_id,
+            .count = state[species_id]});
+    };
+
+    if (sampling->species.empty())
+    {
+        for (unsigned int species_id = 0; species_id < state.size(); species_id++)
+            sample(species_id);
+    }
+    else
+    {
+        for (int species_id : sampling->species)
+            sample(species_id);
+    }
+
+    if (species_counts.size() >= history_chunk_size)
+    {
+        species_count_queue->insert_history(
+            HistoryPacket<SpeciesCountHistoryElement>{
+                .seed = seed,
+                .history = std::move(species_counts)});
+
+        species_counts = std::vector<SpeciesCountHistoryElement>();
+        species_counts.reserve(history_chunk_size);
+    }
+} // record_sample()
+
+/* ------------------------------------------------------------------- */
+
+template <typename Solver>
+void Simulation<Solver>::sample_state(const std::vector<int> &state, double until)
+{
+    double sample_time;
+    while ((sample_time = next_sample * sampling->interval) < until &&
+           sample_time <= sampling->end)
+        record_sample(state);
+} // sample_state()
+
+/* ------------------------------------------------------------------- */
+
+template <typename Solver>
+void Simulation<Solver>::finish_sampling(const std::vector<int> &state)
+{
+    // without an end the state would have to be sampled forever
+    if (!std::isfinite(sampling->end))
+        return;
+
+    while (next_sample * sampling->interval <= sampling->end)
+        record_sample(state);
+} // finish_sampling()
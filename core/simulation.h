@@ -15,8 +15,12 @@ See the README file in the top-level RNMC directory.
 #include <unistd.h>
 #include <string>
 #include <cstring>
+#include <vector>
 
 #include "../GMC/tree_solver.h"
+#include "RNMC_types.h"
+#include "sql_types.h"
+#include "queues.h"
 
 // In the GNUC Library, sig_atomic_t is a typedef for int,
 // which is atomic on all systems that are supported by the
@@ -38,7 +42,13 @@ public:
     double time;
     int step; // number of reactions which have occoured
     unsigned long int history_chunk_size;
-    std::function<void(Update)> update_function;
+
+    // set by start_sampling() if the state is sampled instead of
+    // recording every reaction
+    const Sampling *sampling;
+    unsigned long int next_sample; // index of the next sample time
+    std::vector<SpeciesCountHistoryElement> species_counts;
+    HistoryQueue<HistoryPacket<SpeciesCountHistoryElement>> *species_count_queue;
 
     Simulation(unsigned long int seed,
                int history_chunk_size,
@@ -46,12 +56,30 @@ public:
                double time) : seed(seed),
                               time(time),
                               step(step),
-                              history_chunk_size(history_chunk_size) {};
+                              history_chunk_size(history_chunk_size),
+                              sampling(nullptr),
+                              next_sample(0),
+                              species_counts(),
+                              species_count_queue(nullptr) {};
 
     void execute_steps(int step_cutoff);
     void execute_time(double time_cutoff);
     virtual bool execute_step();
     void write_error_message(std::string s);
+
+    void start_sampling(const Sampling &sampling,
+                        HistoryQueue<HistoryPacket<SpeciesCountHistoryElement>> &species_count_queue);
+
+    // record state at the sample times before until, the time of the
+    // next reaction. state holds from the current time until then.
+    void sample_state(const std::vector<int> &state, double until);
+
+    // record state at the remaining sample times up to the end of the
+    // sampling once no reaction can occur
+    void finish_sampling(const std::vector<int> &state);
+
+private:
+    void record_sample(const std::vector<int> &state);
 };
 
 #include "simulation.cpp"
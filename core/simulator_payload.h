@@ -8,9 +8,12 @@ See the README file in the top-level RNMC directory.
 #ifndef RNMC_SIMULATOR_PAYLOAD_H
 #define RNMC_SIMULATOR_PAYLOAD_H
 
+#include <map>
+
 #include "simulation.h"
 #include "RNMC_types.h"
 #include "queues.h"
+#include "sql_types.h"
 
 /* ----------------------------------------------------------------------
     size of history chunks which we write to the database.
@@ -39,31 +42,43 @@ public:
     HistoryQueue<HistoryPacket<TrajHistory>> &history_queue;
     HistoryQueue<HistoryPacket<StateHistory>> &state_history_queue;
     HistoryQueue<HistoryPacket<CutoffHistory>> &cutoff_history_queue;
+    HistoryQueue<HistoryPacket<SpeciesCountHistoryElement>> &species_count_queue;
     SeedQueue &seed_queue;
+    SeedChunk seed_chunk; // seeds claimed by this thread
     Cutoff cutoff;
-    std::vector<bool>::iterator running;
-    std::map<int, State> seed_state_map;
-    std::map<int, int> seed_step_map;
-    std::map<int, double> seed_time_map;
+    Sampling sampling;
+    HistorySignal &history_signal;
+
+    // start of the seeds with a checkpoint, shared by all the threads.
+    // the maps are not modified while the threads run. a seed is only
+    // claimed by one thread, which moves its state out of the map.
+    std::map<int, State> &seed_state_map;
+    const std::map<int, int> &seed_step_map;
+    const std::map<int, double> &seed_time_map;
 
     SimulatorPayload(
         Model &model,
         HistoryQueue<HistoryPacket<TrajHistory>> &history_queue,
         HistoryQueue<HistoryPacket<StateHistory>> &state_history_queue,
         HistoryQueue<HistoryPacket<CutoffHistory>> &cutoff_history_queue,
+        HistoryQueue<HistoryPacket<SpeciesCountHistoryElement>> &species_count_queue,
         SeedQueue &seed_queue,
         Cutoff cutoff,
-        std::vector<bool>::iterator running,
-        std::map<int, State> seed_state_map,
-        std::map<int, int> seed_step_map,
-        std::map<int, double> seed_time_map) : model(model),
+        Sampling sampling,
+        HistorySignal &history_signal,
+        std::map<int, State> &seed_state_map,
+        const std::map<int, int> &seed_step_map,
+        const std::map<int, double> &seed_time_map) : model(model),
                                                history_queue(history_queue),
                                                state_history_queue(state_history_queue),
                                                cutoff_history_queue(cutoff_history_queue),
+                                               species_count_queue(species_count_queue),
                                                seed_queue(seed_queue),
+                                               seed_chunk{.next = 0, .end = 0},
                                                cutoff(cutoff),
-                                               running(running),
-                                               seed_state_map(std::move(seed_state_map)),
+                                               sampling(sampling),
+                                               history_signal(history_signal),
+                                               seed_state_map(seed_state_map),
                                                seed_step_map(seed_step_map),
                                                seed_time_map(seed_time_map) {};
 
@@ -71,17 +86,28 @@ public:
     {
 
         while (std::optional<unsigned long int> maybe_seed =
-                   seed_queue.get_seed())
+                   seed_queue.get_seed(seed_chunk))
         {
 
             unsigned long int seed = maybe_seed.value();
-            int step = seed_step_map[seed];
-            double time = seed_time_map[seed];
 
-            Sim simulation(model, seed, step, time, seed_state_map[seed],
+            auto step_it = seed_step_map.find(seed);
+            int step = step_it != seed_step_map.end() ? step_it->second : 0;
+            auto time_it = seed_time_map.find(seed);
+            double time = time_it != seed_time_map.end() ? time_it->second : 0.0;
+
+            // seeds without a checkpoint start from a copy of the initial
+            // state of the model, made only now
+            auto state_it = seed_state_map.find(seed);
+            Sim simulation(model, seed, step, time,
+                           state_it != seed_state_map.end() ? std::move(state_it->second)
+                                                            : State(model.initial_state),
                            history_chunk_size, history_queue);
             simulation.init();
 
+            if (sampling.interval > 0.0)
+                simulation.start_sampling(sampling, species_count_queue);
+
             switch (cutoff.type_of_cutoff)
             {
             case step_termination:
@@ -119,14 +145,21 @@ public:
             }
 
             // Move the remainder of the history into the queue to be saved
-            history_queue.insert_history(
-                std::move(
-                    HistoryPacket<TrajHistory>{
+            if (!simulation.history.empty())
+                history_queue.insert_history(
+                    std::move(
+                        HistoryPacket<TrajHistory>{
+                            .seed = seed,
+                            .history = std::move(simulation.history)}));
+
+            if (!simulation.species_counts.empty())
+                species_count_queue.insert_history(
+                    HistoryPacket<SpeciesCountHistoryElement>{
                         .seed = seed,
-                        .history = std::move(simulation.history)}));
+                        .history = std::move(simulation.species_counts)});
         }
 
-        *running = false;
+        history_signal.simulator_finished();
     };
 };
 
@@ -36,6 +36,24 @@ public:
     };
 };
 
+// pragmas applied to the initial state database while a run writes to
+// it. in WAL mode a commit appends to the log instead of rewriting
+// pages in place, and with synchronous NORMAL the log is only synced
+// at checkpoints, so a commit no longer waits for the disk. OFF never
+// syncs, which is faster again, but the database can be corrupted if
+// the machine (rather than the process) goes down during the run.
+struct SqlWriteProfile
+{
+    std::string synchronous; // NORMAL or OFF
+    int cache_size_mib;
+    long int mmap_size_mib;
+};
+
+constexpr int default_cache_size_mib = 256;
+constexpr long int default_mmap_size_mib = 1024;
+
+/* ------------------------------------------------------------------- */
+
 class SqlConnection
 {
 public:
@@ -44,7 +62,8 @@ public:
 
     // method for executing standalone sql statements.
     // for reading and writing data, use SqlReader or SqlWriter classes.
-    void exec(std::string sql_statement)
+    // returns false if the statement failed.
+    bool exec(std::string sql_statement)
     {
         int rc;
         char *error_message = 0;
@@ -62,6 +81,55 @@ public:
             strcat(error, error_message);
             std::cerr << error << std::endl;
         }
+
+        return rc == SQLITE_OK;
+    };
+
+    // method for checking whether a standalone query returns any rows,
+    // for instance whether an index exists.
+    bool has_rows(std::string sql_statement)
+    {
+        sqlite3_stmt *stmt;
+        int rc = sqlite3_prepare_v2(
+            connection,
+            sql_statement.c_str(),
+            -1,
+            &stmt,
+            nullptr);
+
+        if (rc != SQLITE_OK)
+        {
+            std::cerr << time::time_stamp()
+                      << "sqlite: "
+                      << sqlite3_errmsg(connection)
+                      << '\n';
+            std::abort();
+        }
+
+        bool result = sqlite3_step(stmt) == SQLITE_ROW;
+        sqlite3_finalize(stmt);
+        return result;
+    };
+
+    void apply_write_profile(SqlWriteProfile profile)
+    {
+        exec("PRAGMA journal_mode = WAL;");
+        exec("PRAGMA synchronous = " + profile.synchronous + ";");
+        exec("PRAGMA cache_size = " + std::to_string(-1024l * profile.cache_size_mib) + ";");
+        exec("PRAGMA temp_store = MEMORY;");
+        exec("PRAGMA mmap_size = " + std::to_string(1048576l * profile.mmap_size_mib) + ";");
+    };
+
+    // back to the sqlite defaults. leaving WAL mode checkpoints the log
+    // into the database and removes it, so the file can be copied or
+    // opened by readers which do not support WAL.
+    void restore_default_profile()
+    {
+        exec("PRAGMA journal_mode = DELETE;");
+        exec("PRAGMA synchronous = FULL;");
+        exec("PRAGMA cache_size = -2000;");
+        exec("PRAGMA temp_store = DEFAULT;");
+        exec("PRAGMA mmap_size = 0;");
     };
 
     void close()
@@ -127,14 +195,21 @@ private:
 
 public:
     void action(T &r) { T::action(r, stmt); };
+    // bind the parameters of r starting at first_parameter, for
+    // statements holding several rows
+    void action(T &r, int first_parameter) { T::action(r, stmt, first_parameter); };
     void reset() { sqlite3_reset(stmt); };
     int step() { return sqlite3_step(stmt); };
+    int parameter_count() { return sqlite3_bind_parameter_count(stmt); };
+
+    SqlStatement(SqlConnection &sql_connection) : SqlStatement(sql_connection, T::sql_statement) {};
 
-    SqlStatement(SqlConnection &sql_connection) : sql_connection(sql_connection)
+    SqlStatement(SqlConnection &sql_connection,
+                 std::string sql_statement) : sql_connection(sql_connection)
     {
         int rc = sqlite3_prepare_v2(
             sql_connection.connection,
-            T::sql_statement.c_str(),
+            sql_statement.c_str(),
             -1,
             &stmt,
             nullptr);
@@ -234,4 +309,65 @@ public:
     };
 };
 
+/* ------------------------------------------------------------------- */
+
+// inserts rows_per_statement rows with each step of a multi row
+// INSERT ... VALUES (...), (...) statement, which saves a reset and a
+// pass through the sqlite virtual machine per row. the statement is
+// built from T::sql_statement, which must end with a single VALUES
+// tuple, and T::action must take the index of its first parameter.
+// rows left over at the end of a vector use the single row statement.
+
+constexpr int rows_per_statement = 64;
+
+template <typename T>
+class SqlMultiRowWriter
+{
+private:
+    SqlStatement<T> single_row_statement;
+    int parameters_per_row;
+    SqlStatement<T> multi_row_statement;
+
+    static std::string multi_row_sql(int parameters_per_row)
+    {
+        std::string sql = T::sql_statement.substr(0, T::sql_statement.rfind("VALUES"));
+        sql += "VALUES ";
+
+        std::string row = "(?";
+        for (int i = 1; i < parameters_per_row; i++)
+            row += ", ?";
+        row += ")";
+
+        for (int i = 0; i < rows_per_statement; i++)
+            sql += (i == 0 ? "" : ", ") + row;
+
+        return sql + ";";
+    };
+
+public:
+    SqlMultiRowWriter(SqlConnection &sql_connection) : single_row_statement(sql_connection),
+                                                       parameters_per_row(single_row_statement.parameter_count()),
+                                                       multi_row_statement(sql_connection,
+                                                                           multi_row_sql(parameters_per_row)) {};
+
+    void insert(std::vector<T> &rows)
+    {
+        unsigned long int i = 0;
+        for (; i + rows_per_statement <= rows.size(); i += rows_per_statement)
+        {
+            multi_row_statement.reset();
+            for (int j = 0; j < rows_per_statement; j++)
+                multi_row_statement.action(rows[i + j], j * parameters_per_row + 1);
+            multi_row_statement.step();
+        }
+
+        for (; i < rows.size(); i++)
+        {
+            single_row_statement.reset();
+            single_row_statement.action(rows[i], 1);
+            single_row_statement.step();
+        }
+    };
+};
+
 #endif
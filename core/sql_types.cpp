@@ -36,6 +36,17 @@ void WriteCutoffSql::action(WriteCutoffSql &r, sqlite3_stmt *stmt)
     sqlite3_bind_double(stmt, 3, r.time);
 }
 
+std::string WriteSpeciesCountSql::sql_statement =
+    "INSERT OR IGNORE INTO species_counts VALUES (?1, ?2, ?3, ?4);";
+
+void WriteSpeciesCountSql::action(WriteSpeciesCountSql &r, sqlite3_stmt *stmt, int first_parameter)
+{
+    sqlite3_bind_int(stmt, first_parameter, r.seed);
+    sqlite3_bind_double(stmt, first_parameter + 1, r.time);
+    sqlite3_bind_int(stmt, first_parameter + 2, r.species_id);
+    sqlite3_bind_int(stmt, first_parameter + 3, r.count);
+}
+
 std::string FactorsSql::sql_statement =
     "SELECT factor_zero, factor_two, factor_duplicate FROM factors";
 
@@ -47,6 +47,26 @@ public:
     static void action(WriteCutoffSql &r, sqlite3_stmt *stmt);
 };
 
+// count of a species at one of the sample times of a Sampling
+struct SpeciesCountHistoryElement
+{
+    unsigned long int seed;
+    double time;
+    int species_id;
+    int count;
+};
+
+class WriteSpeciesCountSql
+{
+public:
+    int seed;
+    double time;
+    int species_id;
+    int count;
+    static std::string sql_statement;
+    static void action(WriteSpeciesCountSql &r, sqlite3_stmt *stmt, int first_parameter = 1);
+};
+
 class FactorsSql
 {
 public:
@@ -0,0 +1,964 @@
+/* ----------------------------------------------------------------------
+RNMC - Reaction Network Monte Carlo
+https://blaugroup.github.io/RNMC/
+
+See the README file in the top-level RNMC directory.
+---------------------------------------------------------------------- */
+
+#ifndef RNMC_TRAJECTORY_FILE_H
+#define RNMC_TRAJECTORY_FILE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <utility>
+#include <iostream>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// DESIGN
+// append only binary file holding the trajectories of a run, as an
+// alternative to the trajectories table of the initial state database.
+// the file is made of
+//   header   magic, version and the type and name of every column
+//   chunks   one per history packet. a TrajectoryChunkHeader followed
+//            by the values of each column of the packet one column
+//            after another, raw or packed
+//   index    a TrajectoryIndexEntry per chunk, sorted by seed and then
+//            by position in the file
+//   trailer  position of the index, number of chunks and the magic
+// the seed of a packet is stored once in its chunk header rather than
+// as a column. numbers are stored in the byte order of the machine
+// which wrote the file. the index and trailer are written when the
+// writer is closed and replaced when more chunks are appended by a
+// later run. if a run is killed before that, the chunks which were
+// written completely are found again by walking the chunk headers.
+// the steps which the next run simulates again are appended once more,
+// the reader only returns the rows written first for each step.
+//
+// the columns of a row type are described by a list of
+// TrajectoryColumn, giving the offset of each column in the row, so
+// any of the WriteTrajectoriesSql types can be written.
+//
+// the columns of a chunk are either stored as plain arrays, which the
+// reader hands out without copying, or packed. a packed chunk starts
+// with the size in bytes of each of its columns. every column is
+// handled as a sequence of 64 bit integers, doubles by their bit
+// pattern, and stored with whichever ColumnCodec is smallest for that
+// column of that chunk: steps go up by one, so they are stored as a
+// first value and a stride only, times are monotone so only the
+// differences of their bit patterns are stored, and reaction ids or
+// site mappings are bit packed, delta or run length coded depending on
+// how they are spread.
+//
+// a packed GMC step takes about 7.4 bytes, against about 25 bytes in
+// the trajectories table without its unique index. time takes about 6
+// of those bytes: the difference of consecutive bit patterns is close
+// to dt / ulp(time), around 39 bits wide, and its low bits are random,
+// so no lossless coding of time gets much below 5 bytes.
+
+enum TrajectoryColumnType : uint32_t
+{
+    column_int32 = 0,
+    column_float64 = 1
+};
+
+struct TrajectoryColumn
+{
+    std::string name;
+    TrajectoryColumnType type;
+    unsigned long int offset; // of the column in the row type
+};
+
+constexpr char trajectory_file_magic[8] = {'R', 'N', 'M', 'C', 'T', 'R', 'J', '1'};
+constexpr uint32_t trajectory_file_version = 1;
+constexpr uint32_t trajectory_chunk_marker = 0x4b4e4843; // "CHNK"
+
+enum TrajectoryChunkEncoding : uint32_t
+{
+    chunk_raw = 0,   // columns stored as plain arrays
+    chunk_packed = 1 // columns stored with a ColumnCodec each
+};
+
+enum ColumnCodec : uint8_t
+{
+    codec_stride = 0,       // first value and the constant difference
+    codec_varint = 1,       // zigzag varint of each value
+    codec_varint_delta = 2, // zigzag varint of each difference
+    codec_bits = 3,         // blocks of values bit packed above the block minimum
+    codec_bits_delta = 4,   // blocks of differences bit packed above the block minimum
+    codec_runs = 5          // zigzag varint of each value repeated and the length of its run
+};
+
+constexpr unsigned long int codec_block_size = 32;
+
+struct TrajectoryChunkHeader
+{
+    uint32_t marker;
+    uint32_t encoding;
+    uint64_t seed;
+    uint64_t number_of_rows;
+    uint64_t size; // bytes of column data following the header
+};
+
+struct TrajectoryIndexEntry
+{
+    uint64_t seed;
+    uint64_t offset; // of the chunk header in the file
+    uint64_t number_of_rows;
+};
+
+struct TrajectoryTrailer
+{
+    uint64_t index_offset;
+    uint64_t number_of_chunks;
+    char magic[8];
+};
+
+inline unsigned long int column_width(TrajectoryColumnType type)
+{
+    return type == column_int32 ? 4 : 8;
+}
+
+inline unsigned long int pad_to_8(unsigned long int size)
+{
+    return (size + 7) & ~7ul;
+}
+
+inline void trajectory_file_error(std::string path, std::string message)
+{
+    std::cerr << "trajectory file " << path << ": " << message << '\n';
+    std::abort();
+}
+
+/* ------------------------------------------------------------------- */
+
+inline uint64_t zigzag(uint64_t value)
+{
+    return (value << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(value) >> 63);
+}
+
+inline uint64_t unzigzag(uint64_t value)
+{
+    return (value >> 1) ^ (~(value & 1) + 1);
+}
+
+inline unsigned long int varint_size(uint64_t value)
+{
+    unsigned long int size = 1;
+    while (value >= 128)
+    {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+inline void put_varint(std::vector<char> &out, uint64_t value)
+{
+    while (value >= 128)
+    {
+        out.push_back(static_cast<char>((value & 127) | 128));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+inline uint64_t get_varint(const char *&position)
+{
+    uint64_t value = 0;
+    int shift = 0;
+    while (true)
+    {
+        uint8_t byte = static_cast<uint8_t>(*position++);
+        value |= static_cast<uint64_t>(byte & 127) << shift;
+        if (byte < 128)
+            return value;
+        shift += 7;
+    }
+}
+
+inline int bit_width(uint64_t value)
+{
+    return value == 0 ? 0 : 64 - __builtin_clzll(value);
+}
+
+// column of rows as 64 bit integers, ints sign extended and doubles by
+// their bit pattern
+template <typename Row>
+void column_values(const std::vector<Row> &rows,
+                   const TrajectoryColumn &column,
+                   std::vector<uint64_t> &values)
+{
+    values.resize(rows.size());
+    for (unsigned long int i = 0; i < rows.size(); i++)
+    {
+        const char *field = reinterpret_cast<const char *>(&rows[i]) + column.offset;
+        if (column.type == column_int32)
+        {
+            int32_t value;
+            std::memcpy(&value, field, 4);
+            values[i] = static_cast<uint64_t>(static_cast<int64_t>(value));
+        }
+        else
+            std::memcpy(&values[i], field, 8);
+    }
+}
+
+// differences of consecutive values, the first value is kept
+inline void column_deltas(const std::vector<uint64_t> &values,
+                          std::vector<uint64_t> &deltas)
+{
+    deltas.resize(values.size());
+    for (unsigned long int i = 0; i < values.size(); i++)
+        deltas[i] = i == 0 ? values[0] : values[i] - values[i - 1];
+}
+
+inline uint64_t block_minimum(const uint64_t *values, unsigned long int n)
+{
+    int64_t minimum = static_cast<int64_t>(values[0]);
+    for (unsigned long int i = 1; i < n; i++)
+        minimum = std::min(minimum, static_cast<int64_t>(values[i]));
+    return static_cast<uint64_t>(minimum);
+}
+
+inline int block_width(const uint64_t *values, unsigned long int n, uint64_t minimum)
+{
+    uint64_t spread = 0;
+    for (unsigned long int i = 0; i < n; i++)
+        spread |= values[i] - minimum;
+    return bit_width(spread);
+}
+
+// bytes needed to store values with a codec, not counting the codec
+inline unsigned long int codec_size(ColumnCodec codec, const std::vector<uint64_t> &values)
+{
+    unsigned long int size = 0;
+    switch (codec)
+    {
+    case codec_stride:
+        if (values.size() > 0)
+            size += varint_size(zigzag(values[0]));
+        if (values.size() > 1)
+            size += varint_size(zigzag(values[1] - values[0]));
+        break;
+    case codec_varint:
+    case codec_varint_delta:
+        for (uint64_t value : values)
+            size += varint_size(zigzag(value));
+        break;
+    case codec_bits:
+    case codec_bits_delta:
+        for (unsigned long int i = 0; i < values.size(); i += codec_block_size)
+        {
+            unsigned long int n = std::min(codec_block_size, values.size() - i);
+            uint64_t minimum = block_minimum(&values[i], n);
+            int width = block_width(&values[i], n, minimum);
+            size += varint_size(zigzag(minimum)) + 1 + (width * n + 7) / 8;
+        }
+        break;
+    case codec_runs:
+        for (unsigned long int i = 0, run = 1; i < values.size(); i += run)
+        {
+            for (run = 1; i + run < values.size() && values[i + run] == values[i]; run++)
+                ;
+            size += varint_size(zigzag(values[i])) + varint_size(run);
+        }
+        break;
+    }
+    return size;
+}
+
+inline void put_codec(std::vector<char> &out, ColumnCodec codec, const std::vector<uint64_t> &values)
+{
+    switch (codec)
+    {
+    case codec_stride:
+        if (values.size() > 0)
+            put_varint(out, zigzag(values[0]));
+        if (values.size() > 1)
+            put_varint(out, zigzag(values[1] - values[0]));
+        break;
+    case codec_varint:
+    case codec_varint_delta:
+        for (uint64_t value : values)
+            put_varint(out, zigzag(value));
+        break;
+    case codec_bits:
+    case codec_bits_delta:
+        for (unsigned long int i = 0; i < values.size(); i += codec_block_size)
+        {
+            unsigned long int n = std::min(codec_block_size, values.size() - i);
+            uint64_t minimum = block_minimum(&values[i], n);
+            int width = block_width(&values[i], n, minimum);
+            put_varint(out, zigzag(minimum));
+            out.push_back(static_cast<char>(width));
+
+            unsigned long int begin = out.size();
+            out.resize(begin + (width * n + 7) / 8, 0);
+            uint8_t *bits = reinterpret_cast<uint8_t *>(out.data() + begin);
+            unsigned long int position = 0;
+            for (unsigned long int j = 0; j < n; j++)
+            {
+                uint64_t value = values[i + j] - minimum;
+                for (int written = 0; written < width;)
+                {
+                    int offset = position & 7;
+                    int take = std::min(8 - offset, width - written);
+                    bits[position >> 3] |= static_cast<uint8_t>(((value >> written) & ((1u << take) - 1)) << offset);
+                    written += take;
+                    position += take;
+                }
+            }
+        }
+        break;
+    case codec_runs:
+        for (unsigned long int i = 0, run = 1; i < values.size(); i += run)
+        {
+            for (run = 1; i + run < values.size() && values[i + run] == values[i]; run++)
+                ;
+            put_varint(out, zigzag(values[i]));
+            put_varint(out, run);
+        }
+        break;
+    }
+}
+
+// decode n values stored with a codec. the values are left as stored,
+// differences are summed by the caller.
+inline void get_codec(const char *position, ColumnCodec codec,
+                      unsigned long int n, std::vector<uint64_t> &values)
+{
+    values.resize(n);
+    switch (codec)
+    {
+    case codec_stride:
+    {
+        uint64_t first = n > 0 ? unzigzag(get_varint(position)) : 0;
+        uint64_t stride = n > 1 ? unzigzag(get_varint(position)) : 0;
+        for (unsigned long int i = 0; i < n; i++)
+            values[i] = first + i * stride;
+        break;
+    }
+    case codec_varint:
+    case codec_varint_delta:
+        for (unsigned long int i = 0; i < n; i++)
+            values[i] = unzigzag(get_varint(position));
+        break;
+    case codec_bits:
+    case codec_bits_delta:
+        for (unsigned long int i = 0; i < n; i += codec_block_size)
+        {
+            unsigned long int block = std::min(codec_block_size, n - i);
+            uint64_t minimum = unzigzag(get_varint(position));
+            int width = static_cast<uint8_t>(*position++);
+
+            const uint8_t *bits = reinterpret_cast<const uint8_t *>(position);
+            unsigned long int bit = 0;
+            for (unsigned long int j = 0; j < block; j++)
+            {
+                uint64_t value = 0;
+                for (int read = 0; read < width;)
+                {
+                    int offset = bit & 7;
+                    int take = std::min(8 - offset, width - read);
+                    value |= static_cast<uint64_t>((bits[bit >> 3] >> offset) & ((1u << take) - 1)) << read;
+                    read += take;
+                    bit += take;
+                }
+                values[i + j] = value + minimum;
+            }
+            position += (width * block + 7) / 8;
+        }
+        break;
+    case codec_runs:
+        for (unsigned long int i = 0; i < n;)
+        {
+            uint64_t value = unzigzag(get_varint(position));
+            unsigned long int run = get_varint(position);
+            for (unsigned long int end = std::min(n, i + run); i < end; i++)
+                values[i] = value;
+        }
+        break;
+    }
+
+    if (codec == codec_varint_delta || codec == codec_bits_delta)
+        for (unsigned long int i = 1; i < n; i++)
+            values[i] += values[i - 1];
+}
+
+/* ------------------------------------------------------------------- */
+
+// serialized header of a file with the given columns
+inline std::vector<char> trajectory_file_header(const std::vector<TrajectoryColumn> &columns)
+{
+    std::vector<char> header(trajectory_file_magic, trajectory_file_magic + 8);
+
+    auto put_uint32 = [&](uint32_t value)
+    {
+        const char *bytes = reinterpret_cast<const char *>(&value);
+        header.insert(header.end(), bytes, bytes + 4);
+    };
+
+    put_uint32(trajectory_file_version);
+    put_uint32(columns.size());
+    for (const TrajectoryColumn &column : columns)
+    {
+        put_uint32(column.type);
+        put_uint32(column.name.size());
+        header.insert(header.end(), column.name.begin(), column.name.end());
+    }
+
+    header.resize(pad_to_8(header.size()), 0);
+    return header;
+}
+
+/* ------------------------------------------------------------------- */
+
+// parse the header at the start of data. returns the size of the
+// header, or 0 if data does not start with a valid header.
+inline unsigned long int parse_trajectory_file_header(const char *data,
+                                                      unsigned long int size,
+                                                      std::vector<TrajectoryColumn> &columns)
+{
+    unsigned long int position = 16;
+    uint32_t version, number_of_columns;
+
+    if (size < position || std::memcmp(data, trajectory_file_magic, 8) != 0)
+        return 0;
+
+    std::memcpy(&version, data + 8, 4);
+    std::memcpy(&number_of_columns, data + 12, 4);
+    if (version != trajectory_file_version)
+        return 0;
+
+    columns.clear();
+    for (uint32_t i = 0; i < number_of_columns; i++)
+    {
+        uint32_t type, name_length;
+        if (position + 8 > size)
+            return 0;
+        std::memcpy(&type, data + position, 4);
+        std::memcpy(&name_length, data + position + 4, 4);
+        position += 8;
+
+        if (position + name_length > size)
+            return 0;
+        columns.push_back(TrajectoryColumn{
+            .name = std::string(data + position, name_length),
+            .type = static_cast<TrajectoryColumnType>(type),
+            .offset = 0});
+        position += name_length;
+    }
+
+    return pad_to_8(position);
+}
+
+/* ------------------------------------------------------------------- */
+
+// packed columns of a chunk, each column prefixed by its codec
+template <typename Row>
+std::vector<char> pack_trajectory_columns(const std::vector<Row> &rows,
+                                          const std::vector<TrajectoryColumn> &columns)
+{
+    std::vector<char> out(4 * columns.size(), 0);
+    std::vector<uint64_t> values, deltas;
+
+    for (unsigned long int c = 0; c < columns.size(); c++)
+    {
+        column_values(rows, columns[c], values);
+        column_deltas(values, deltas);
+
+        bool constant_stride = true;
+        for (unsigned long int i = 2; i < deltas.size(); i++)
+            constant_stride = constant_stride && deltas[i] == deltas[1];
+
+        ColumnCodec best = codec_varint;
+        unsigned long int best_size = codec_size(codec_varint, values);
+        for (ColumnCodec codec : {codec_stride, codec_varint_delta, codec_bits, codec_bits_delta, codec_runs})
+        {
+            if (codec == codec_stride && !constant_stride)
+                continue;
+            unsigned long int size = codec_size(
+                codec, codec == codec_varint_delta || codec == codec_bits_delta ? deltas : values);
+            if (size < best_size)
+            {
+                best = codec;
+                best_size = size;
+            }
+        }
+
+        unsigned long int begin = out.size();
+        out.push_back(static_cast<char>(best));
+        put_codec(out, best, best == codec_varint_delta || best == codec_bits_delta ? deltas : values);
+
+        uint32_t size = out.size() - begin;
+        std::memcpy(out.data() + 4 * c, &size, 4);
+    }
+
+    out.resize(pad_to_8(out.size()), 0);
+    return out;
+}
+
+/* ------------------------------------------------------------------- */
+
+// raw columns of a chunk, each padded to 8 bytes
+template <typename Row>
+std::vector<char> raw_trajectory_columns(const std::vector<Row> &rows,
+                                         const std::vector<TrajectoryColumn> &columns)
+{
+    unsigned long int size = 0;
+    for (const TrajectoryColumn &column : columns)
+        size += pad_to_8(rows.size() * column_width(column.type));
+
+    std::vector<char> out(size, 0);
+    char *position = out.data();
+    for (const TrajectoryColumn &column : columns)
+    {
+        unsigned long int width = column_width(column.type);
+        for (unsigned long int i = 0; i < rows.size(); i++)
+        {
+            std::memcpy(position + i * width,
+                        reinterpret_cast<const char *>(&rows[i]) + column.offset,
+                        width);
+        }
+        position += pad_to_8(rows.size() * width);
+    }
+
+    return out;
+}
+
+/* ------------------------------------------------------------------- */
+
+// the chunk of a history packet, with its header, in the layout it has
+// in the file. built by the converter threads so the writer thread
+// only has to append it.
+template <typename Row>
+std::vector<char> encode_trajectory_chunk(unsigned long int seed,
+                                          const std::vector<Row> &rows,
+                                          const std::vector<TrajectoryColumn> &columns,
+                                          TrajectoryChunkEncoding encoding = chunk_raw)
+{
+    std::vector<char> payload = encoding == chunk_packed
+                                    ? pack_trajectory_columns(rows, columns)
+                                    : raw_trajectory_columns(rows, columns);
+
+    TrajectoryChunkHeader header{
+        .marker = trajectory_chunk_marker,
+        .encoding = encoding,
+        .seed = seed,
+        .number_of_rows = rows.size(),
+        .size = payload.size()};
+
+    std::vector<char> chunk(sizeof(TrajectoryChunkHeader) + payload.size());
+    std::memcpy(chunk.data(), &header, sizeof(TrajectoryChunkHeader));
+    if (!payload.empty())
+        std::memcpy(chunk.data() + sizeof(TrajectoryChunkHeader), payload.data(), payload.size());
+    return chunk;
+}
+
+/* ------------------------------------------------------------------- */
+
+// index of the complete chunks between begin and end of data, in file
+// order. returns the position after the last complete chunk.
+inline unsigned long int scan_trajectory_chunks(const char *data,
+                                                unsigned long int begin,
+                                                unsigned long int end,
+                                                std::vector<TrajectoryIndexEntry> &index)
+{
+    unsigned long int position = begin;
+    while (position + sizeof(TrajectoryChunkHeader) <= end)
+    {
+        TrajectoryChunkHeader header;
+        std::memcpy(&header, data + position, sizeof(TrajectoryChunkHeader));
+
+        if (header.marker != trajectory_chunk_marker ||
+            header.size > end - position - sizeof(TrajectoryChunkHeader))
+            break;
+
+        index.push_back(TrajectoryIndexEntry{
+            .seed = header.seed,
+            .offset = position,
+            .number_of_rows = header.number_of_rows});
+        position += sizeof(TrajectoryChunkHeader) + header.size;
+    }
+
+    return position;
+}
+
+/* ------------------------------------------------------------------- */
+
+// index of a file from its trailer. returns false if data does not end
+// with a valid trailer.
+inline bool read_trajectory_index(const char *data,
+                                  unsigned long int header_size,
+                                  unsigned long int size,
+                                  std::vector<TrajectoryIndexEntry> &index)
+{
+    TrajectoryTrailer trailer;
+    if (size < header_size + sizeof(TrajectoryTrailer))
+        return false;
+
+    std::memcpy(&trailer, data + size - sizeof(TrajectoryTrailer), sizeof(TrajectoryTrailer));
+    if (std::memcmp(trailer.magic, trajectory_file_magic, 8) != 0 ||
+        trailer.index_offset < header_size ||
+        trailer.index_offset + trailer.number_of_chunks * sizeof(TrajectoryIndexEntry) +
+                sizeof(TrajectoryTrailer) !=
+            size)
+        return false;
+
+    index.resize(trailer.number_of_chunks);
+    std::memcpy(index.data(), data + trailer.index_offset,
+                trailer.number_of_chunks * sizeof(TrajectoryIndexEntry));
+    return true;
+}
+
+/* ------------------------------------------------------------------- */
+
+// maps a whole file read only. an empty file gives data == nullptr.
+class MappedFile
+{
+public:
+    const char *data;
+    unsigned long int size;
+
+    MappedFile(std::string path) : data(nullptr), size(0)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            trajectory_file_error(path, "cannot open for reading");
+
+        struct stat st;
+        fstat(fd, &st);
+        size = st.st_size;
+
+        if (size > 0)
+        {
+            void *mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            if (mapping == MAP_FAILED)
+                trajectory_file_error(path, "cannot map");
+            data = static_cast<const char *>(mapping);
+        }
+
+        close(fd);
+    };
+
+    ~MappedFile()
+    {
+        if (data)
+            munmap(const_cast<char *>(data), size);
+    };
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+};
+
+/* ------------------------------------------------------------------- */
+
+class TrajectoryFileWriter
+{
+private:
+    std::string path;
+    FILE *file;
+    std::vector<TrajectoryIndexEntry> index;
+
+public:
+    TrajectoryFileWriter(std::string path,
+                         const std::vector<TrajectoryColumn> &columns) : path(path),
+                                                                         file(nullptr)
+    {
+        std::vector<char> header = trajectory_file_header(columns);
+        unsigned long int end = header.size();
+
+        struct stat st;
+        if (stat(path.c_str(), &st) == 0 && st.st_size > 0)
+        {
+            // appending to the file of an earlier run. its index is
+            // overwritten by the new chunks and written again on close.
+            MappedFile existing(path);
+            std::vector<TrajectoryColumn> existing_columns;
+            unsigned long int header_size = parse_trajectory_file_header(
+                existing.data, existing.size, existing_columns);
+
+            if (header_size != header.size() ||
+                std::memcmp(existing.data, header.data(), header.size()) != 0)
+                trajectory_file_error(path, "exists with different columns");
+
+            if (read_trajectory_index(existing.data, header_size, existing.size, index))
+            {
+                TrajectoryTrailer trailer;
+                std::memcpy(&trailer, existing.data + existing.size - sizeof(TrajectoryTrailer),
+                            sizeof(TrajectoryTrailer));
+                end = trailer.index_offset;
+            }
+            else
+            {
+                std::cerr << "trajectory file " << path
+                          << " has no index, recovering the complete chunks\n";
+                end = scan_trajectory_chunks(existing.data, header_size, existing.size, index);
+            }
+
+            file = fopen(path.c_str(), "r+b");
+            if (!file || ftruncate(fileno(file), end) != 0)
+                trajectory_file_error(path, "cannot open for appending");
+            fseek(file, end, SEEK_SET);
+        }
+        else
+        {
+            file = fopen(path.c_str(), "wb");
+            if (!file)
+                trajectory_file_error(path, "cannot create");
+            fwrite(header.data(), 1, header.size(), file);
+        }
+    };
+
+    ~TrajectoryFileWriter()
+    {
+        close();
+    };
+
+    TrajectoryFileWriter(const TrajectoryFileWriter &) = delete;
+    TrajectoryFileWriter &operator=(const TrajectoryFileWriter &) = delete;
+
+    // append a chunk made by encode_trajectory_chunk
+    void append(const std::vector<char> &chunk)
+    {
+        TrajectoryChunkHeader header;
+        std::memcpy(&header, chunk.data(), sizeof(TrajectoryChunkHeader));
+
+        index.push_back(TrajectoryIndexEntry{
+            .seed = header.seed,
+            .offset = static_cast<uint64_t>(ftell(file)),
+            .number_of_rows = header.number_of_rows});
+
+        if (fwrite(chunk.data(), 1, chunk.size(), file) != chunk.size())
+            trajectory_file_error(path, "write failed");
+    };
+
+    void flush()
+    {
+        fflush(file);
+    };
+
+    // write the index and trailer
+    void close()
+    {
+        if (!file)
+            return;
+
+        std::stable_sort(index.begin(), index.end(),
+                         [](const TrajectoryIndexEntry &a, const TrajectoryIndexEntry &b)
+                         { return a.seed < b.seed; });
+
+        TrajectoryTrailer trailer{
+            .index_offset = static_cast<uint64_t>(ftell(file)),
+            .number_of_chunks = index.size(),
+            .magic = {}};
+        std::memcpy(trailer.magic, trajectory_file_magic, 8);
+
+        fwrite(index.data(), sizeof(TrajectoryIndexEntry), index.size(), file);
+        fwrite(&trailer, sizeof(TrajectoryTrailer), 1, file);
+
+        if (fclose(file) != 0)
+            trajectory_file_error(path, "write failed");
+        file = nullptr;
+    };
+};
+
+/* ------------------------------------------------------------------- */
+
+// reads a trajectory file through a read only mapping. the columns of
+// a chunk are returned as pointers into the mapping, so reading a seed
+// does not copy its rows. chunks are numbered by their position in
+// the index, where the chunks of a seed are next to each other and in
+// the order they were written.
+//
+// a seed can be written more than once, for instance when a run is
+// killed and the seeds it had not finished are simulated again from
+// their last checkpoint by the next run. as with the trajectories
+// table, the first row written for a step is kept: the rows at the
+// start of a chunk whose steps an earlier chunk of the seed already
+// reached are skipped, and chunks left without rows are not numbered.
+class TrajectoryFileReader
+{
+private:
+    std::string path;
+    MappedFile file;
+    std::vector<TrajectoryColumn> columns;
+    std::vector<TrajectoryIndexEntry> index;
+    std::vector<unsigned long int> skipped_rows; // per chunk in index
+
+    void skip_repeated_steps()
+    {
+        skipped_rows.assign(index.size(), 0);
+
+        int step_column = column_index("step");
+        if (step_column < 0 || columns[step_column].type != column_int32)
+            return;
+
+        std::vector<TrajectoryIndexEntry> kept_index;
+        std::vector<unsigned long int> kept_skipped_rows;
+        std::vector<int> buffer;
+        bool seed_has_rows = false;
+        int last_step = 0;
+
+        for (unsigned long int c = 0; c < index.size(); c++)
+        {
+            if (c == 0 || index[c].seed != index[c - 1].seed)
+                seed_has_rows = false;
+
+            unsigned long int number_of_rows = index[c].number_of_rows;
+            const int *steps = column<int>(c, step_column, buffer);
+
+            unsigned long int skip = 0;
+            if (seed_has_rows)
+                while (skip < number_of_rows && steps[skip] <= last_step)
+                    skip++;
+
+            if (skip == number_of_rows)
+                continue;
+
+            last_step = seed_has_rows ? std::max(last_step, steps[number_of_rows - 1])
+                                      : steps[number_of_rows - 1];
+            seed_has_rows = true;
+
+            kept_index.push_back(index[c]);
+            kept_skipped_rows.push_back(skip);
+        }
+
+        index = std::move(kept_index);
+        skipped_rows = std::move(kept_skipped_rows);
+    };
+
+public:
+    TrajectoryFileReader(std::string path) : path(path),
+                                             file(path)
+    {
+        unsigned long int header_size = parse_trajectory_file_header(file.data, file.size, columns);
+        if (header_size == 0)
+            trajectory_file_error(path, "is not a trajectory file");
+
+        // the run writing the file was killed or is still running
+        if (!read_trajectory_index(file.data, header_size, file.size, index))
+        {
+            scan_trajectory_chunks(file.data, header_size, file.size, index);
+            std::stable_sort(index.begin(), index.end(),
+                             [](const TrajectoryIndexEntry &a, const TrajectoryIndexEntry &b)
+                             { return a.seed < b.seed; });
+        }
+
+        skip_repeated_steps();
+    };
+
+    const std::vector<TrajectoryColumn> &get_columns() const
+    {
+        return columns;
+    };
+
+    // -1 if there is no column called name
+    int column_index(std::string name) const
+    {
+        for (unsigned long int i = 0; i < columns.size(); i++)
+            if (columns[i].name == name)
+                return i;
+        return -1;
+    };
+
+    unsigned long int number_of_chunks() const
+    {
+        return index.size();
+    };
+
+    // number_of_rows does not count the skipped rows
+    TrajectoryIndexEntry chunk(unsigned long int i) const
+    {
+        TrajectoryIndexEntry entry = index[i];
+        entry.number_of_rows -= skipped_rows[i];
+        return entry;
+    };
+
+    // chunks [first, last) of a seed
+    std::pair<unsigned long int, unsigned long int> chunks_of_seed(unsigned long int seed) const
+    {
+        auto range = std::equal_range(
+            index.begin(), index.end(),
+            TrajectoryIndexEntry{.seed = seed, .offset = 0, .number_of_rows = 0},
+            [](const TrajectoryIndexEntry &a, const TrajectoryIndexEntry &b)
+            { return a.seed < b.seed; });
+
+        return std::make_pair(range.first - index.begin(), range.second - index.begin());
+    };
+
+    TrajectoryChunkEncoding encoding(unsigned long int chunk) const
+    {
+        TrajectoryChunkHeader header;
+        std::memcpy(&header, file.data + index[chunk].offset, sizeof(TrajectoryChunkHeader));
+        return static_cast<TrajectoryChunkEncoding>(header.encoding);
+    };
+
+    // the values of a column of a raw chunk, T must match the column
+    // type. the values are read from the mapping without copying.
+    template <typename T>
+    const T *column(unsigned long int chunk, int column) const
+    {
+        if (sizeof(T) != column_width(columns[column].type))
+            trajectory_file_error(path, "wrong type for column " + columns[column].name);
+        if (encoding(chunk) != chunk_raw)
+            trajectory_file_error(path, "chunk is packed, read it into a buffer");
+
+        const char *position = file.data + index[chunk].offset + sizeof(TrajectoryChunkHeader);
+        for (int c = 0; c < column; c++)
+            position += pad_to_8(index[chunk].number_of_rows * column_width(columns[c].type));
+
+        return reinterpret_cast<const T *>(position) + skipped_rows[chunk];
+    };
+
+    // the values of a column of any chunk. packed columns are decoded
+    // into buffer, raw columns are still read without copying.
+    template <typename T>
+    const T *column(unsigned long int chunk, int column, std::vector<T> &buffer) const
+    {
+        TrajectoryChunkEncoding chunk_encoding = encoding(chunk);
+        if (chunk_encoding == chunk_raw)
+            return this->column<T>(chunk, column);
+        if (chunk_encoding != chunk_packed)
+            trajectory_file_error(path, "unknown chunk encoding");
+        if (sizeof(T) != column_width(columns[column].type))
+            trajectory_file_error(path, "wrong type for column " + columns[column].name);
+
+        const char *sizes = file.data + index[chunk].offset + sizeof(TrajectoryChunkHeader);
+        const char *position = sizes + 4 * columns.size();
+        for (int c = 0; c < column; c++)
+        {
+            uint32_t size;
+            std::memcpy(&size, sizes + 4 * c, 4);
+            position += size;
+        }
+
+        std::vector<uint64_t> values;
+        ColumnCodec codec = static_cast<ColumnCodec>(*position);
+        get_codec(position + 1, codec, index[chunk].number_of_rows, values);
+
+        buffer.resize(values.size());
+        for (unsigned long int i = 0; i < values.size(); i++)
+        {
+            if (columns[column].type == column_int32)
+            {
+                int32_t value = static_cast<int32_t>(values[i]);
+                std::memcpy(&buffer[i], &value, 4);
+            }
+            else
+                std::memcpy(&buffer[i], &values[i], 8);
+        }
+
+        return buffer.data() + skipped_rows[chunk];
+    };
+};
+
+#endif
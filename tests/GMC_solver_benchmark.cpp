@@ -0,0 +1,69 @@
+/* ----------------------------------------------------------------------
+Benchmark for the GMC tree solvers
+Times a simulation-like loop of one event followed by a handful of
+propensity updates for networks of 10^3 to 10^7 reactions.
+Not part of the unit tests, build with make GMC_solver_benchmark
+---------------------------------------------------------------------- */
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include "../GMC/tree_solver.h"
+#include "../GMC/kary_tree_solver.h"
+
+// number of propensity updates after each event, roughly the number of
+// reactions depending on the species of a fired reaction
+constexpr int updates_per_event = 8;
+constexpr int number_of_events = 1000000;
+
+template <typename Solver>
+double benchmark(std::vector<double> &initial_propensities)
+{
+    Solver solver(42, initial_propensities);
+    unsigned long int number_of_reactions = initial_propensities.size();
+    unsigned long int index = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < number_of_events; i++)
+    {
+        Event event = solver.event().value();
+
+        // spread the updates over the whole network like the
+        // dependents of a reaction usually are
+        index = event.index;
+        for (int j = 0; j < updates_per_event; j++)
+        {
+            index = (index * 2654435761ul + j) % number_of_reactions;
+            solver.update(Update{.index = index,
+                                 .propensity = 1.0 + (index % 100)});
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(end - start).count() / number_of_events;
+} // benchmark()
+
+/* ---------------------------------------------------------------------- */
+
+int main()
+{
+    std::cout << "reactions  TreeSolver (ns/step)  KaryTreeSolver (ns/step)\n";
+
+    for (unsigned long int number_of_reactions = 1000;
+         number_of_reactions <= 10000000;
+         number_of_reactions *= 10)
+    {
+        std::vector<double> initial_propensities(number_of_reactions);
+        for (unsigned long int i = 0; i < number_of_reactions; i++)
+            initial_propensities[i] = 1.0 + (i % 100);
+
+        double tree_time = benchmark<TreeSolver>(initial_propensities);
+        double kary_tree_time = benchmark<KaryTreeSolver>(initial_propensities);
+
+        std::cout << number_of_reactions << "  "
+                  << tree_time << "  "
+                  << kary_tree_time << "\n";
+    }
+
+    return 0;
+}
@@ -7,6 +7,8 @@ All tests use googletest unit test framework
 #include "../GMC/linear_solver.h"
 #include "../GMC/tree_solver.h"
 #include "../GMC/sparse_solver.h"
+#include "../GMC/composition_rejection_solver.h"
+#include "../GMC/kary_tree_solver.h"
 
 TEST(GMC_solvers, GMC_solvers)
 {
@@ -19,6 +21,7 @@ TEST(GMC_solvers, GMC_solvers)
         0.1, 0, 0};
 
     TreeSolver tree_solver(42, std::ref(initial_propensities));
+    KaryTreeSolver kary_tree_solver(42, std::ref(initial_propensities));
     LinearSolver linear_solver_unused(42, std::ref(initial_propensities));
     SparseSolver sparse_solver(42, std::ref(initial_propensities));
     LinearSolver linear_solver(42, std::move(initial_propensities));
@@ -28,7 +31,158 @@ TEST(GMC_solvers, GMC_solvers)
         Event linear_event = linear_solver.event().value();
         Event tree_event = tree_solver.event().value();
         Event sparse_event = sparse_solver.event().value();
+        Event kary_tree_event = kary_tree_solver.event().value();
         EXPECT_EQ(linear_event.index, tree_event.index);
         EXPECT_EQ(linear_event.index, sparse_event.index);
+        EXPECT_EQ(linear_event.index, kary_tree_event.index);
     }
-}
\ No newline at end of file
+}
+TEST(GMC_solvers, composition_rejection_solver)
+{
+
+    std::vector<double> propensities = {
+        0, 0, 0, 0.1,
+        0, 0, 0, 0, 0.2,
+        0, 0.3,
+        0, 0, 0.1,
+        0.1, 0, 0};
+
+    CompositionRejectionSolver solver(42, std::ref(propensities));
+    EXPECT_DOUBLE_EQ(solver.get_propensity_sum(), 0.8);
+
+    // move indices between groups, switch some on and some off
+    std::vector<Update> updates = {
+        Update{.index = 3, .propensity = 0.0},
+        Update{.index = 0, .propensity = 4.0},
+        Update{.index = 10, .propensity = 0.25},
+        Update{.index = 16, .propensity = 1e-3}};
+    solver.update(updates);
+    for (Update update : updates)
+    {
+        propensities[update.index] = update.propensity;
+        EXPECT_EQ(solver.get_propensity(update.index), update.propensity);
+    }
+
+    double propensity_sum = 0.0;
+    for (double propensity : propensities)
+        propensity_sum += propensity;
+    EXPECT_DOUBLE_EQ(solver.get_propensity_sum(), propensity_sum);
+
+    // sampled frequencies should match the propensities
+    int number_of_events = 200000;
+    std::vector<int> counts(propensities.size(), 0);
+    for (int i = 0; i < number_of_events; i++)
+        counts[solver.event().value().index]++;
+
+    for (unsigned int i = 0; i < propensities.size(); i++)
+    {
+        EXPECT_NEAR(counts[i] / (double)number_of_events,
+                    propensities[i] / propensity_sum, 0.005);
+    }
+
+    // no events once every propensity is zero
+    for (unsigned long int i = 0; i < propensities.size(); i++)
+        solver.update(Update{.index = i, .propensity = 0.0});
+    EXPECT_FALSE(solver.event().has_value());
+}
+
+TEST(GMC_solvers, kary_tree_solver)
+{
+    // enough indices for several levels of the k-ary tree. the
+    // propensities are multiples of 1/8 so that both trees compute
+    // the same sums exactly.
+    std::vector<double> propensities(1000);
+    for (unsigned int i = 0; i < propensities.size(); i++)
+        propensities[i] = (i % 7) * 0.125;
+
+    TreeSolver tree_solver(42, std::ref(propensities));
+    KaryTreeSolver kary_tree_solver(42, std::ref(propensities));
+    EXPECT_EQ(tree_solver.get_propensity_sum(), kary_tree_solver.get_propensity_sum());
+
+    for (int i = 0; i < 10000; i++)
+    {
+        Event tree_event = tree_solver.event().value();
+        Event kary_tree_event = kary_tree_solver.event().value();
+        EXPECT_EQ(tree_event.index, kary_tree_event.index);
+        EXPECT_EQ(tree_event.dt, kary_tree_event.dt);
+
+        // switch the firing reaction off and some other one on
+        Update off = Update{.index = tree_event.index, .propensity = 0.0};
+        Update on = Update{.index = (tree_event.index * 37 + i) % propensities.size(),
+                           .propensity = (i % 5 + 1) * 0.25};
+        tree_solver.update(off);
+        tree_solver.update(on);
+        kary_tree_solver.update(std::vector<Update>{off, on});
+        EXPECT_EQ(kary_tree_solver.get_propensity(on.index), on.propensity);
+    }
+
+    EXPECT_EQ(tree_solver.get_propensity_sum(), kary_tree_solver.get_propensity_sum());
+
+    // no events once every propensity is zero
+    for (unsigned long int i = 0; i < propensities.size(); i++)
+        kary_tree_solver.update(Update{.index = i, .propensity = 0.0});
+    EXPECT_FALSE(kary_tree_solver.event().has_value());
+}
+
+TEST(GMC_solvers, tree_solver_batch_update)
+{
+    std::vector<double> propensities(300);
+    for (unsigned int i = 0; i < propensities.size(); i++)
+        propensities[i] = (i % 3) * 0.5;
+
+    TreeSolver sequential_solver(42, std::ref(propensities));
+    TreeSolver batch_solver(42, std::ref(propensities));
+
+    for (int i = 0; i < 1000; i++)
+    {
+        // batches with repeated indices and neighbouring leaves, as
+        // produced by reactions sharing dependent species
+        std::vector<Update> updates;
+        for (unsigned long int j = 0; j < 20; j++)
+            updates.push_back(Update{
+                .index = (i * 7 + j * j) % propensities.size(),
+                .propensity = ((i + j) % 4) * 0.25});
+
+        for (Update update : updates)
+            sequential_solver.update(update);
+        batch_solver.update(updates);
+
+        EXPECT_EQ(sequential_solver.get_propensity_sum(), batch_solver.get_propensity_sum());
+
+        Event sequential_event = sequential_solver.event().value();
+        Event batch_event = batch_solver.event().value();
+        EXPECT_EQ(sequential_event.index, batch_event.index);
+    }
+}
+
+TEST(GMC_solvers, linear_solver_drift)
+{
+    // one large propensity switching on and off swamps the low order
+    // bits of a plain running sum of the small ones
+    std::vector<double> initial_propensities(1000, 0.1);
+    initial_propensities[0] = 1e12;
+
+    LinearSolver linear_solver(42, std::ref(initial_propensities));
+    linear_solver.set_resync_interval(100);
+
+    // finish with the large propensity switched off
+    double exact = 0.0;
+    for (int i = 0; i <= 100000; i++)
+    {
+        int index = 1 + i % 999;
+        linear_solver.update(Update{.index = static_cast<unsigned long>(index),
+                                    .propensity = 0.1 + 0.01 * (i % 7)});
+        linear_solver.update(Update{.index = 0,
+                                    .propensity = (i % 2) ? 1e12 : 1e-3});
+    }
+
+    for (int i = 0; i < 1000; i++)
+        exact += linear_solver.get_propensity(i);
+
+    // the compensated sum stays within a rounding of the exact sum
+    // between resyncs, and a resync only corrects that much
+    EXPECT_NEAR(linear_solver.get_propensity_sum(), exact, 1e-9 * exact);
+    linear_solver.event();
+    EXPECT_NEAR(linear_solver.get_propensity_sum(), exact, 1e-12 * exact);
+    EXPECT_LT(linear_solver.get_drift(), 1e-6);
+}
@@ -123,3 +123,65 @@ TEST(lattice_reaction_network_test, dependents)
    EXPECT_EQ(static_LGMC_.dependents[4][2], 3);
    EXPECT_EQ(static_LGMC_.dependents[4][3], 8);
 }
+
+TEST(lattice_reaction_network_test, PropensityTable)
+{
+   LatticePropensityTable props;
+
+   // enough site pairs to make the table grow several times
+   for (int site = 0; site < 5000; site++)
+   {
+      int bucket = props.find_or_insert(site, site + 1);
+      EXPECT_EQ(bucket, site);
+      props.add(bucket, 0.5 * site, site);
+   }
+   int self_bucket = props.find_or_insert(7, SITE_SELF_REACTION);
+   int homogeneous_bucket = props.find_or_insert(7, SITE_HOMOGENEOUS);
+   EXPECT_NE(self_bucket, homogeneous_bucket);
+
+   // the order of the sites does not matter, the larger site comes first
+   for (int site = 0; site < 5000; site++)
+   {
+      EXPECT_EQ(props.find(site + 1, site), site);
+      EXPECT_EQ(props.buckets[site].site_one, site + 1);
+      EXPECT_EQ(props.buckets[site].site_two, site);
+      EXPECT_EQ(props.sum_bucket(site), 0.5 * site);
+   }
+   EXPECT_EQ(props.find(SITE_SELF_REACTION, 7), self_bucket);
+   EXPECT_EQ(props.buckets[homogeneous_bucket].site_two, SITE_HOMOGENEOUS);
+   EXPECT_EQ(props.find(3, 5), -1);
+   EXPECT_EQ(props.find_or_insert(5000, 4999), 4999);
+}
+
+TEST(lattice_reaction_network_test, PropensitySumTree)
+{
+   LatticePropensityTable props;
+
+   for (int site = 0; site < 100; site++)
+   {
+      int bucket = props.find_or_insert(site, SITE_HOMOGENEOUS);
+      props.add(bucket, 1.0, 2 * site);
+      props.add(bucket, 2.0, 2 * site + 1);
+   }
+   EXPECT_DOUBLE_EQ(props.get_propensity_sum(), 300.0);
+
+   // cleared buckets drop out of the sum and can never be selected
+   for (int site = 0; site < 100; site += 2)
+      props.clear_bucket(props.find(site, SITE_HOMOGENEOUS));
+   EXPECT_DOUBLE_EQ(props.get_propensity_sum(), 150.0);
+
+   for (double value = 0.5; value < 150.0; value += 1.0)
+   {
+      double remainder = value;
+      int bucket = props.find_bucket(remainder);
+      EXPECT_EQ(bucket % 2, 1);
+      EXPECT_EQ(bucket, 2 * int(value / 3.0) + 1);
+      EXPECT_NEAR(remainder, value - 3.0 * int(value / 3.0), 1e-9);
+   }
+
+   // leaves are set exactly so adding propensities back restores the sum
+   props.add(props.find(0, SITE_HOMOGENEOUS), 3.0, 0);
+   EXPECT_DOUBLE_EQ(props.get_propensity_sum(), 153.0);
+   double value = 1.0;
+   EXPECT_EQ(props.find_bucket(value), 0);
+}
@@ -5,9 +5,37 @@ All tests use googletest unit test framework
 
 #include "gtest/gtest.h"
 #include <string>
+#include <cstdlib>
+#include <new>
 
 #include "../core/sql.h"
 #include "../NPMC/nano_particle.h"
+#include "../NPMC/nano_solver.h"
+
+// count the heap allocations made while counting is switched on
+static bool count_allocations = false;
+static long number_of_allocations = 0;
+
+void *operator new(std::size_t size)
+{
+    if (count_allocations)
+        number_of_allocations++;
+
+    void *pointer = std::malloc(size == 0 ? 1 : size);
+    if (!pointer)
+        throw std::bad_alloc();
+    return pointer;
+}
+
+void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
 
 class NanoParticleTEST : public ::testing::Test
 {
@@ -71,16 +99,254 @@ TEST_F(NanoParticleTEST, SiteDistanceSquared)
     EXPECT_EQ(nano_particle_.site_distance_squared(s2, s4), 0.99);
 }
 
-TEST_F(NanoParticleTEST, DistanceMatrix)
+TEST_F(NanoParticleTEST, InteractionTables)
+{
+    EXPECT_EQ(nano_particle_.number_of_species_states, 2 + 4 + 5);
+
+    // every row must hold the matching interactions in order of id
+    auto ids = [](const std::vector<Interaction> &interactions, int begin, int end)
+    {
+        std::vector<int> ids;
+        for (int i = begin; i < end; i++)
+            ids.push_back(interactions[i].interaction_id);
+        return ids;
+    };
+
+    int number_of_species = nano_particle_.degrees_of_freedom.size();
+    for (int species_0 = 0; species_0 < number_of_species; species_0++)
+    {
+        for (int state_0 = 0; state_0 < nano_particle_.degrees_of_freedom[species_0]; state_0++)
+        {
+            int a = nano_particle_.species_state_offset[species_0] + state_0;
+
+            std::vector<int> expected;
+            for (Interaction &interaction : nano_particle_.all_interactions)
+                if (interaction.number_of_sites == 1 &&
+                    interaction.species_id[0] == species_0 && interaction.left_state[0] == state_0)
+                    expected.push_back(interaction.interaction_id);
+
+            EXPECT_EQ(ids(nano_particle_.one_site_interactions,
+                          nano_particle_.one_site_interaction_offsets[a],
+                          nano_particle_.one_site_interaction_offsets[a + 1]),
+                      expected);
+
+            for (int species_1 = 0; species_1 < number_of_species; species_1++)
+            {
+                for (int state_1 = 0; state_1 < nano_particle_.degrees_of_freedom[species_1]; state_1++)
+                {
+                    int b = nano_particle_.species_state_offset[species_1] + state_1;
+                    int row = a * nano_particle_.number_of_species_states + b;
+
+                    expected.clear();
+                    for (Interaction &interaction : nano_particle_.all_interactions)
+                        if (interaction.number_of_sites == 2 &&
+                            interaction.species_id[0] == species_0 && interaction.left_state[0] == state_0 &&
+                            interaction.species_id[1] == species_1 && interaction.left_state[1] == state_1)
+                            expected.push_back(interaction.interaction_id);
+
+                    EXPECT_EQ(ids(nano_particle_.two_site_interactions,
+                                  nano_particle_.two_site_interaction_offsets[row],
+                                  nano_particle_.two_site_interaction_offsets[row + 1]),
+                              expected);
+                }
+            }
+        }
+    }
+
+    EXPECT_EQ(nano_particle_.one_site_interactions.size() + nano_particle_.two_site_interactions.size(),
+              nano_particle_.all_interactions.size());
+}
+
+// neighbor lists must agree with testing every pair of sites
+static void expect_brute_force_neighbors(NanoParticle &nano_particle)
 {
-    // SiteDistanceSquare previously tested
-    // testing location of distances in distance matrix
-    for (int i = 0; i < static_cast<int>(nano_particle_.distance_matrix.size()); i++)
+    int number_of_sites = nano_particle.sites.size();
+    ASSERT_EQ(static_cast<int>(nano_particle.neighbor_offsets.size()), number_of_sites + 1);
+
+    for (int i = 0; i < number_of_sites; i++)
     {
-        for (int j = 0; j < static_cast<int>(nano_particle_.distance_matrix[i].size()); j++)
+        std::vector<int> expected;
+        for (int j = 0; j < number_of_sites; j++)
+        {
+            double distance = std::sqrt(nano_particle.site_distance_squared(nano_particle.sites[i],
+                                                                            nano_particle.sites[j]));
+            if (i != j && distance < nano_particle.interaction_radius_bound)
+                expected.push_back(j);
+        }
+
+        std::vector<int> found(nano_particle.neighbor_ids.begin() + nano_particle.neighbor_offsets[i],
+                               nano_particle.neighbor_ids.begin() + nano_particle.neighbor_offsets[i + 1]);
+        EXPECT_EQ(found, expected);
+
+        for (int k = nano_particle.neighbor_offsets[i]; k < nano_particle.neighbor_offsets[i + 1]; k++)
         {
-            EXPECT_EQ(nano_particle_.distance_matrix[i][j],
-                      std::sqrt(nano_particle_.site_distance_squared(nano_particle_.sites[i], nano_particle_.sites[j])));
+            EXPECT_EQ(nano_particle.neighbor_distances[k],
+                      std::sqrt(nano_particle.site_distance_squared(nano_particle.sites[i],
+                                                                    nano_particle.sites[nano_particle.neighbor_ids[k]])));
         }
     }
 }
+
+TEST_F(NanoParticleTEST, SiteNeighbors)
+{
+    expect_brute_force_neighbors(nano_particle_);
+}
+
+TEST_F(NanoParticleTEST, NeighborDistanceFactors)
+{
+    ASSERT_EQ(nano_particle_.neighbor_distance_factors.size(),
+              nano_particle_.neighbor_ids.size());
+
+    for (unsigned int k = 0; k < nano_particle_.neighbor_distances.size(); k++)
+    {
+        EXPECT_EQ(nano_particle_.neighbor_distance_factors[k],
+                  nano_particle_.distance_factor_function(
+                      nano_particle_.neighbor_distances[k]));
+    }
+}
+
+TEST(NanoParticleNeighborsTEST, CellLists)
+{
+    // a jittered cubic lattice much larger than the interaction radius,
+    // so most pairs of sites are in cells which are not adjacent
+    NanoParticle nano_particle;
+    for (int i = 0; i < 12; i++)
+        for (int j = 0; j < 12; j++)
+            for (int k = 0; k < 12; k++)
+            {
+                int n = (i * 12 + j) * 12 + k;
+                nano_particle.sites.push_back(NanoSite{
+                    .x = i + 0.3 * std::sin(n),
+                    .y = j + 0.3 * std::cos(3 * n),
+                    .z = 0.5 * k + 0.2 * std::sin(7 * n),
+                    .species_id = 0});
+            }
+
+    for (double radius : {0.2, 1.0, 1.7, 3.0, 100.0})
+    {
+        nano_particle.interaction_radius_bound = radius;
+        nano_particle.compute_site_neighbors();
+        expect_brute_force_neighbors(nano_particle);
+    }
+}
+
+TEST(NanoSolverTEST, UpdateReactionSlots)
+{
+    std::vector<NanoReaction> reactions(5);
+    for (int i = 0; i < 5; i++)
+        reactions[i].rate = i + 1;
+
+    NanoSolver solver(42, std::ref(reactions));
+    EXPECT_EQ(solver.get_propensity_sum(), 15);
+
+    // overwrite a slot and append past the initial capacity of the tree
+    std::vector<int> changed_reactions = {1};
+    solver.current_reactions[1].rate = 10;
+    for (int i = 0; i < 6; i++)
+    {
+        NanoReaction reaction;
+        reaction.rate = 1;
+        solver.current_reactions.push_back(reaction);
+        changed_reactions.push_back(solver.current_reactions.size() - 1);
+    }
+    solver.update(changed_reactions);
+    EXPECT_EQ(solver.get_propensity(1), 10);
+    EXPECT_EQ(solver.get_propensity_sum(), 29);
+
+    // move the last reaction into slot 0 and drop the last four
+    changed_reactions = {0};
+    solver.current_reactions[0] = solver.current_reactions[10];
+    solver.current_reactions.resize(7);
+    solver.update(changed_reactions);
+    EXPECT_EQ(solver.get_propensity_sum(), 1 + 10 + 3 + 4 + 5 + 1 + 1);
+
+    // events are only drawn from current reactions, in proportion to their rates
+    int number_of_events = 100000;
+    std::vector<int> counts(solver.current_reactions.size(), 0);
+    for (int i = 0; i < number_of_events; i++)
+    {
+        unsigned long int index = solver.event().value().index;
+        ASSERT_LT(index, solver.current_reactions.size());
+        counts[index]++;
+    }
+
+    for (unsigned int i = 0; i < counts.size(); i++)
+    {
+        EXPECT_NEAR(counts[i] / (double)number_of_events,
+                    solver.current_reactions[i].rate / 25.0, 0.01);
+    }
+
+    // no events without reactions
+    solver.current_reactions.clear();
+    changed_reactions.clear();
+    solver.update(changed_reactions);
+    EXPECT_FALSE(solver.event().has_value());
+}
+
+TEST_F(NanoParticleTEST, UpdateReactionsDoesNotAllocate)
+{
+    std::vector<int> state = nano_particle_.initial_state;
+    SiteReactionLists site_reaction_dependency;
+    std::vector<NanoReaction> reactions;
+    nano_particle_.compute_reactions(state, reactions, site_reaction_dependency);
+
+    NanoSolver solver(42, std::move(reactions));
+    std::vector<int> changed_reactions;
+    NanoReactionScratch scratch;
+
+    // the same steps as NanoParticleSimulation::execute_step, without
+    // recording the history
+    auto step = [&]()
+    {
+        std::optional<Event> maybe_event = solver.event();
+        if (!maybe_event)
+            return false;
+
+        NanoReaction next_reaction = solver.current_reactions[maybe_event.value().index];
+        nano_particle_.update_state(state, next_reaction);
+
+        changed_reactions.clear();
+        nano_particle_.update_reactions(state, next_reaction,
+                                        site_reaction_dependency,
+                                        solver.current_reactions,
+                                        changed_reactions,
+                                        scratch);
+        solver.update(changed_reactions);
+        return true;
+    };
+
+    // let the buffers grow to the largest number of reactions
+    for (int i = 0; i < 10000; i++)
+        ASSERT_TRUE(step());
+
+    number_of_allocations = 0;
+    count_allocations = true;
+    bool stepped = true;
+    for (int i = 0; i < 10000 && stepped; i++)
+        stepped = step();
+    count_allocations = false;
+
+    EXPECT_TRUE(stepped);
+    EXPECT_EQ(number_of_allocations, 0);
+
+    // the lists still agree with the current reactions
+    for (unsigned int site_id = 0; site_id < nano_particle_.sites.size(); site_id++)
+    {
+        for (int link = site_reaction_dependency.head[site_id]; link != -1;
+             link = site_reaction_dependency.next[link])
+        {
+            ASSERT_LT(static_cast<unsigned int>(link / 2), solver.current_reactions.size());
+            EXPECT_EQ(solver.current_reactions[link / 2].site_id[link % 2], static_cast<int>(site_id));
+        }
+    }
+
+    int number_of_links = 0;
+    for (NanoReaction &reaction : solver.current_reactions)
+        number_of_links += reaction.number_of_sites();
+    int links_found = 0;
+    for (unsigned int site_id = 0; site_id < nano_particle_.sites.size(); site_id++)
+        for (int link = site_reaction_dependency.head[site_id]; link != -1;
+             link = site_reaction_dependency.next[link])
+            links_found++;
+    EXPECT_EQ(links_found, number_of_links);
+}
@@ -0,0 +1,181 @@
+/* ----------------------------------------------------------------------
+Unit tests for the queues shared between the simulator threads and the
+dispatcher
+All tests use googletest unit test framework
+---------------------------------------------------------------------- */
+
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include "../core/queues.h"
+
+struct TestPacket
+{
+    int producer;
+    std::vector<int> history;
+};
+
+TEST(queues_test, HistoryQueue)
+{
+    constexpr int number_of_producers = 4;
+    constexpr int packets_per_producer = 10000;
+
+    HistorySignal history_signal;
+    HistoryQueue<TestPacket> history_queue(&history_signal);
+    history_signal.running_simulators.store(number_of_producers);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < number_of_producers; p++)
+    {
+        producers.push_back(std::thread(
+            [&, p]()
+            {
+                for (int i = 0; i < packets_per_producer; i++)
+                    history_queue.insert_history(TestPacket{.producer = p, .history = {i}});
+                history_signal.simulator_finished();
+            }));
+    }
+
+    // packets of each producer arrive in the order they were inserted
+    // and none are lost when the producers finish
+    std::vector<int> next_packet(number_of_producers, 0);
+    bool finished = false;
+    while (!finished)
+    {
+        history_signal.wait(
+            [&]
+            {
+                return !history_queue.empty() ||
+                       history_signal.all_simulators_finished();
+            });
+        finished = history_signal.all_simulators_finished();
+
+        while (std::optional<TestPacket> packet = history_queue.get_history())
+        {
+            EXPECT_EQ(packet.value().history[0], next_packet[packet.value().producer]);
+            next_packet[packet.value().producer]++;
+        }
+    }
+
+    for (std::thread &producer : producers)
+        producer.join();
+
+    for (int p = 0; p < number_of_producers; p++)
+        EXPECT_EQ(next_packet[p], packets_per_producer);
+    EXPECT_TRUE(history_queue.empty());
+}
+
+TEST(queues_test, HistoryQueueMovesHistory)
+{
+    // the history vector is handed over without being copied
+    HistoryQueue<TestPacket> history_queue;
+    std::vector<int> history(100, 1);
+    int *data = history.data();
+
+    history_queue.insert_history(TestPacket{.producer = 0, .history = std::move(history)});
+    TestPacket packet = std::move(history_queue.get_history().value());
+
+    EXPECT_EQ(packet.history.data(), data);
+    EXPECT_FALSE(history_queue.get_history());
+}
+
+TEST(queues_test, SeedQueue)
+{
+    constexpr int number_of_threads = 4;
+    constexpr unsigned long int number_of_seeds = 10000;
+    constexpr unsigned long int base_seed = 1000;
+
+    // every seed is handed out exactly once, except the excluded ones,
+    // whether threads claim seeds one at a time or in chunks
+    for (unsigned long int chunk_size : {1ul, 7ul, 64ul})
+    {
+        SeedQueue seed_queue(number_of_seeds, base_seed, chunk_size);
+        seed_queue.exclude(base_seed);
+        seed_queue.exclude(base_seed + 500);
+        seed_queue.exclude(base_seed + number_of_seeds - 1);
+        seed_queue.exclude(base_seed + number_of_seeds); // outside the range
+
+        std::vector<std::vector<unsigned long int>> claimed(number_of_threads);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < number_of_threads; t++)
+        {
+            threads.push_back(std::thread(
+                [&, t]()
+                {
+                    SeedChunk seed_chunk{.next = 0, .end = 0};
+                    while (std::optional<unsigned long int> seed =
+                               (t % 2 == 0) ? seed_queue.get_seed(seed_chunk) : seed_queue.get_seed())
+                        claimed[t].push_back(seed.value());
+                }));
+        }
+
+        for (std::thread &thread : threads)
+            thread.join();
+
+        std::vector<int> count(number_of_seeds, 0);
+        for (std::vector<unsigned long int> &seeds : claimed)
+            for (unsigned long int seed : seeds)
+            {
+                ASSERT_GE(seed, base_seed);
+                ASSERT_LT(seed, base_seed + number_of_seeds);
+                count[seed - base_seed]++;
+            }
+
+        for (unsigned long int i = 0; i < number_of_seeds; i++)
+            EXPECT_EQ(count[i], seed_queue.is_excluded(base_seed + i) ? 0 : 1);
+
+        EXPECT_FALSE(seed_queue.get_seed());
+    }
+}
+
+TEST(queues_test, PacketBudget)
+{
+    constexpr int number_of_producers = 4;
+    constexpr int packets_per_producer = 2000;
+    constexpr long int limit = 3;
+
+    PacketBudget packet_budget(limit);
+    HistorySignal history_signal;
+    HistoryQueue<TestPacket> history_queue(&history_signal, &packet_budget);
+    history_signal.running_simulators.store(number_of_producers);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < number_of_producers; p++)
+    {
+        producers.push_back(std::thread(
+            [&, p]()
+            {
+                for (int i = 0; i < packets_per_producer; i++)
+                    history_queue.insert_history(TestPacket{.producer = p, .history = {i}});
+                history_signal.simulator_finished();
+            }));
+    }
+
+    // the producers never get more than limit packets ahead of the
+    // consumer, which releases each packet once it has handled it
+    int received = 0;
+    bool finished = false;
+    while (!finished)
+    {
+        history_signal.wait(
+            [&]
+            {
+                return !history_queue.empty() ||
+                       history_signal.all_simulators_finished();
+            });
+        finished = history_signal.all_simulators_finished();
+
+        while (std::optional<TestPacket> packet = history_queue.get_history())
+        {
+            EXPECT_LE(packet_budget.in_flight.load(), limit);
+            received++;
+            packet_budget.release(1);
+        }
+    }
+
+    for (std::thread &producer : producers)
+        producer.join();
+
+    EXPECT_EQ(received, number_of_producers * packets_per_producer);
+    EXPECT_EQ(packet_budget.in_flight.load(), 0);
+}
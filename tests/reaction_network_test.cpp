@@ -4,10 +4,13 @@ All tests use googletest unit test framework
 ---------------------------------------------------------------------- */
 
 #include <string>
+#include <limits>
 
 #include "../core/sql.h"
 #include "../GMC/gillespie_reaction_network.h"
+#include "../GMC/energy_reaction_network.h"
 #include "../GMC/tree_solver.h"
+#include "../core/reaction_network_simulation.h"
 #include "gtest/gtest.h"
 
 class ReactionNetworkTest : public ::testing::Test
@@ -227,14 +230,159 @@ TEST_F(ReactionNetworkTest, UpdatePropensities)
 
    std::vector<int> state = {0, 10000, 200, 20, 500, 200, 100};
 
-   std::function<void(Update)> update_function = [&](Update update)
-   { tree_solver.update(update); };
+   std::vector<Update> updates;
    reaction_network_.update_state(std::ref(state), 4);
-   reaction_network_.update_propensities(update_function, std::ref(state), 4);
+   reaction_network_.update_propensities(tree_solver, updates, std::ref(state), 4);
 
    EXPECT_EQ(tree_solver.get_propensity(0), 2);
    EXPECT_EQ(tree_solver.get_propensity(1), 40004);
 }
 
+TEST_F(ReactionNetworkTest, SampleState)
+{
+   HistorySignal signal;
+   HistoryQueue<HistoryPacket<ReactionNetworkTrajectoryHistoryElement>> history_queue(&signal);
+   HistoryQueue<HistoryPacket<SpeciesCountHistoryElement>> species_count_queue(&signal);
+
+   ReactionNetworkSimulation<TreeSolver> simulation(reaction_network_, 7, 0, 0.0,
+                                                    reaction_network_.initial_state,
+                                                    1000, history_queue);
+   simulation.init();
+   simulation.execute_steps(300);
+
+   std::vector<ReactionNetworkTrajectoryHistoryElement> history;
+   while (std::optional<HistoryPacket<ReactionNetworkTrajectoryHistoryElement>> packet =
+              history_queue.get_history())
+      history.insert(history.end(), packet->history.begin(), packet->history.end());
+   history.insert(history.end(), simulation.history.begin(), simulation.history.end());
+   ASSERT_FALSE(history.empty());
+
+   // the same seed again, sampling the state instead. small packets so
+   // some of the samples go through the queue.
+   Sampling sampling{.interval = history.back().time / 25,
+                     .end = std::numeric_limits<double>::infinity(),
+                     .species = {0, 2, 5}};
+   ReactionNetworkSimulation<TreeSolver> sampled_simulation(reaction_network_, 7, 0, 0.0,
+                                                            reaction_network_.initial_state,
+                                                            64, history_queue);
+   sampled_simulation.init();
+   sampled_simulation.start_sampling(sampling, species_count_queue);
+   sampled_simulation.execute_steps(300);
+
+   EXPECT_TRUE(sampled_simulation.history.empty());
+   EXPECT_TRUE(history_queue.empty());
+
+   std::vector<SpeciesCountHistoryElement> samples;
+   while (std::optional<HistoryPacket<SpeciesCountHistoryElement>> packet =
+              species_count_queue.get_history())
+      samples.insert(samples.end(), packet->history.begin(), packet->history.end());
+   samples.insert(samples.end(), sampled_simulation.species_counts.begin(),
+                  sampled_simulation.species_counts.end());
+
+   // the samples must agree with replaying the reactions up to each
+   // sample time
+   std::vector<int> state = reaction_network_.initial_state;
+   unsigned long int next_reaction = 0;
+   unsigned long int n = 0;
+   for (unsigned long int k = 0; k * sampling.interval < history.back().time; k++)
+   {
+      double time = k * sampling.interval;
+      while (next_reaction < history.size() && history[next_reaction].time <= time)
+         reaction_network_.update_state(std::ref(state), history[next_reaction++].reaction_id);
+
+      for (int species_id : sampling.species)
+      {
+         ASSERT_LT(n, samples.size());
+         EXPECT_EQ(samples[n].time, time);
+         EXPECT_EQ(samples[n].species_id, species_id);
+         EXPECT_EQ(samples[n].count, state[species_id]);
+         n++;
+      }
+   }
+   EXPECT_EQ(n, samples.size());
+   EXPECT_GT(n, 3u * 20);
+}
+
+TEST(EnergyReactionNetworkTest, UpdatePropensities)
+{
+   SqlConnection model_database = SqlConnection("../examples/GMC/energy_budget/rn.sqlite",
+                                                SQLITE_OPEN_READWRITE);
+   SqlConnection initial_state_database = SqlConnection("../examples/GMC/energy_budget/initial_state.sqlite",
+                                                        SQLITE_OPEN_READWRITE);
+
+   EnergyReactionNetworkParameters parameters{.energy_budget = 15.0, .isCheckpoint = false};
+   EnergyReactionNetwork energy_reaction_network(model_database,
+                                                 initial_state_database,
+                                                 parameters);
+
+   EnergyState state = energy_reaction_network.initial_state;
+   std::vector<double> initial_props;
+   energy_reaction_network.compute_initial_energy_propensities(state.homogeneous,
+                                                               state.energy_budget,
+                                                               initial_props);
+   TreeSolver tree_solver = TreeSolver(1, initial_props);
+
+   // only dependents and reactions whose dG crossed the budget are
+   // updated, which must agree with recomputing every propensity
+   int budget_changes = 0;
+   for (int step = 0; step < 300; step++)
+   {
+      std::optional<Event> maybe_event = tree_solver.event();
+      if (!maybe_event)
+         break;
+      int next_reaction = maybe_event.value().index;
+
+      energy_reaction_network.update_state(std::ref(state.homogeneous), next_reaction);
+      double previous_energy_budget = state.energy_budget;
+      energy_reaction_network.update_energy_budget(std::ref(state.energy_budget), next_reaction);
+      energy_reaction_network.update_propensities(tree_solver,
+                                                  std::ref(state.homogeneous),
+                                                  next_reaction,
+                                                  previous_energy_budget,
+                                                  state.energy_budget);
+      if (state.energy_budget != previous_energy_budget)
+         budget_changes++;
+
+      for (int i = 0; i < int(energy_reaction_network.reactions.size()); i++)
+      {
+         ASSERT_EQ(tree_solver.get_propensity(i),
+                   energy_reaction_network.compute_energy_propensity(state.homogeneous, i,
+                                                                     state.energy_budget));
+      }
+   }
+   EXPECT_GT(budget_changes, 0);
+}
+
+TEST(TrajectoryWriterTest, IgnoresDuplicateSteps)
+{
+   SqlConnection database = SqlConnection(":memory:",
+                                          SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+   database.exec("CREATE TABLE trajectories (seed INTEGER NOT NULL, step INTEGER NOT NULL, "
+                 "reaction_id INTEGER NOT NULL, time REAL NOT NULL);");
+   database.exec("CREATE UNIQUE INDEX trajectories_seed_step ON trajectories (seed, step);");
+
+   // the single and multi row statements both keep the first row
+   // written for a step
+   std::vector<ReactionNetworkWriteTrajectoriesSql> rows;
+   for (int step = 0; step < rows_per_statement; step++)
+      rows.push_back({.seed = 7, .step = step, .reaction_id = 1, .time = 0.5 * step});
+   rows.push_back({.seed = 7, .step = 0, .reaction_id = 2, .time = 9.0});
+
+   SqlMultiRowWriter<ReactionNetworkWriteTrajectoriesSql> writer(database);
+   writer.insert(rows);
+
+   std::vector<ReactionNetworkWriteTrajectoriesSql> resumed = {
+       {.seed = 7, .step = 1, .reaction_id = 3, .time = 9.0}};
+   writer.insert(resumed);
+
+   EXPECT_TRUE(database.has_rows(
+       "SELECT 1 FROM trajectories GROUP BY seed HAVING COUNT(*) = " +
+       std::to_string(rows_per_statement) + ";"));
+   EXPECT_TRUE(database.has_rows(
+       "SELECT 1 FROM trajectories WHERE step = 0 AND reaction_id = 1;"));
+   EXPECT_FALSE(database.has_rows(
+       "SELECT 1 FROM trajectories WHERE reaction_id <> 1;"));
+}
+
 // checkpoint
 // store_checkpoint
@@ -0,0 +1,259 @@
+/* ----------------------------------------------------------------------
+Unit tests for the binary trajectory file
+All tests use googletest unit test framework
+---------------------------------------------------------------------- */
+
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include <unistd.h>
+#include "../core/trajectory_file.h"
+
+struct TestRow
+{
+    int seed;
+    int step;
+    int reaction_id;
+    double time;
+};
+
+std::vector<TrajectoryColumn> test_columns = {
+    {.name = "step", .type = column_int32, .offset = offsetof(TestRow, step)},
+    {.name = "reaction_id", .type = column_int32, .offset = offsetof(TestRow, reaction_id)},
+    {.name = "time", .type = column_float64, .offset = offsetof(TestRow, time)}};
+
+std::vector<TestRow> test_rows(int seed, int first_step, int number_of_rows)
+{
+    std::vector<TestRow> rows;
+    for (int i = 0; i < number_of_rows; i++)
+        rows.push_back(TestRow{.seed = seed,
+                               .step = first_step + i,
+                               .reaction_id = (seed * 31 + first_step + i) % 7,
+                               .time = 0.5 * (first_step + i)});
+    return rows;
+}
+
+// every row of seed in the file, chunks in the order they were written
+std::vector<TestRow> read_seed(TrajectoryFileReader &reader, int seed)
+{
+    std::vector<TestRow> rows;
+    int step = reader.column_index("step");
+    int reaction_id = reader.column_index("reaction_id");
+    int time = reader.column_index("time");
+
+    std::vector<int> step_buffer, reaction_id_buffer;
+    std::vector<double> time_buffer;
+
+    auto [first, last] = reader.chunks_of_seed(seed);
+    for (unsigned long int c = first; c < last; c++)
+    {
+        const int *steps = reader.column<int>(c, step, step_buffer);
+        const int *reaction_ids = reader.column<int>(c, reaction_id, reaction_id_buffer);
+        const double *times = reader.column<double>(c, time, time_buffer);
+        for (unsigned long int i = 0; i < reader.chunk(c).number_of_rows; i++)
+            rows.push_back(TestRow{.seed = seed,
+                                   .step = steps[i],
+                                   .reaction_id = reaction_ids[i],
+                                   .time = times[i]});
+    }
+    return rows;
+}
+
+void expect_rows(const std::vector<TestRow> &rows, const std::vector<TestRow> &expected)
+{
+    ASSERT_EQ(rows.size(), expected.size());
+    for (unsigned long int i = 0; i < rows.size(); i++)
+    {
+        EXPECT_EQ(rows[i].step, expected[i].step);
+        EXPECT_EQ(rows[i].reaction_id, expected[i].reaction_id);
+        EXPECT_EQ(rows[i].time, expected[i].time);
+    }
+}
+
+TEST(trajectory_file_test, WriteAppendRead)
+{
+    std::string path = "trajectory_file_test.bin";
+    std::remove(path.c_str());
+
+    {
+        // chunks of different seeds interleaved, as the writer thread sees them
+        TrajectoryFileWriter writer(path, test_columns);
+        writer.append(encode_trajectory_chunk(2, test_rows(2, 0, 5), test_columns));
+        writer.append(encode_trajectory_chunk(1, test_rows(1, 0, 3), test_columns));
+        writer.append(encode_trajectory_chunk(2, test_rows(2, 5, 4), test_columns));
+    }
+
+    {
+        // a later run appends packed chunks to the same file
+        TrajectoryFileWriter writer(path, test_columns);
+        writer.append(encode_trajectory_chunk(1, test_rows(1, 3, 2), test_columns, chunk_packed));
+        writer.append(encode_trajectory_chunk(3, test_rows(3, 0, 1), test_columns, chunk_packed));
+    }
+
+    TrajectoryFileReader reader(path);
+    EXPECT_EQ(reader.get_columns().size(), 3u);
+    EXPECT_EQ(reader.column_index("seed"), -1);
+    EXPECT_EQ(reader.number_of_chunks(), 5u);
+
+    expect_rows(read_seed(reader, 1), test_rows(1, 0, 5));
+    expect_rows(read_seed(reader, 2), test_rows(2, 0, 9));
+    expect_rows(read_seed(reader, 3), test_rows(3, 0, 1));
+    EXPECT_TRUE(read_seed(reader, 4).empty());
+
+    std::remove(path.c_str());
+}
+
+TEST(trajectory_file_test, RecoverWithoutIndex)
+{
+    std::string path = "trajectory_file_recover_test.bin";
+    std::remove(path.c_str());
+
+    std::vector<char> first = encode_trajectory_chunk(1, test_rows(1, 0, 4), test_columns);
+    std::vector<char> second = encode_trajectory_chunk(1, test_rows(1, 4, 4), test_columns);
+    unsigned long int header_size = trajectory_file_header(test_columns).size();
+
+    {
+        TrajectoryFileWriter writer(path, test_columns);
+        writer.append(first);
+        writer.append(second);
+    }
+
+    // a run killed while writing the second chunk leaves no index and
+    // half a chunk
+    ASSERT_EQ(truncate(path.c_str(), header_size + first.size() + second.size() / 2), 0);
+
+    {
+        TrajectoryFileReader reader(path);
+        expect_rows(read_seed(reader, 1), test_rows(1, 0, 4));
+    }
+
+    {
+        // the next run drops the partial chunk before appending
+        TrajectoryFileWriter writer(path, test_columns);
+        writer.append(second);
+    }
+
+    TrajectoryFileReader reader(path);
+    EXPECT_EQ(reader.number_of_chunks(), 2u);
+    expect_rows(read_seed(reader, 1), test_rows(1, 0, 8));
+
+    std::remove(path.c_str());
+}
+
+TEST(trajectory_file_test, AppendSeedTwice)
+{
+    std::string path = "trajectory_file_append_test.bin";
+    std::remove(path.c_str());
+
+    {
+        // a run killed while simulating seed 1, after the chunk of
+        // seed 2 which had resumed from a checkpoint at step 5
+        TrajectoryFileWriter writer(path, test_columns);
+        writer.append(encode_trajectory_chunk(1, test_rows(1, 0, 4), test_columns));
+        writer.append(encode_trajectory_chunk(2, test_rows(2, 5, 3), test_columns));
+        writer.append(encode_trajectory_chunk(1, test_rows(1, 4, 4), test_columns));
+    }
+
+    {
+        // the next run simulates both seeds again, with packets of a
+        // different size, and one row of seed 1 differs from the first run
+        TrajectoryFileWriter writer(path, test_columns);
+        std::vector<TestRow> rows = test_rows(1, 0, 6);
+        rows[2].reaction_id = 100;
+        writer.append(encode_trajectory_chunk(1, rows, test_columns, chunk_packed));
+        writer.append(encode_trajectory_chunk(1, test_rows(1, 6, 6), test_columns, chunk_packed));
+        writer.append(encode_trajectory_chunk(2, test_rows(2, 5, 3), test_columns));
+        writer.append(encode_trajectory_chunk(2, test_rows(2, 8, 2), test_columns, chunk_packed));
+    }
+
+    TrajectoryFileReader reader(path);
+
+    // the first chunk of the second run repeats steps 0 to 5 and the
+    // second chunk repeats steps 6 and 7
+    EXPECT_EQ(reader.number_of_chunks(), 5u);
+    expect_rows(read_seed(reader, 1), test_rows(1, 0, 12));
+    expect_rows(read_seed(reader, 2), test_rows(2, 5, 5));
+
+    auto [first, last] = reader.chunks_of_seed(1);
+    ASSERT_EQ(last - first, 3u);
+    EXPECT_EQ(reader.chunk(first + 2).number_of_rows, 4u);
+
+    std::remove(path.c_str());
+}
+
+TEST(trajectory_file_test, PackedRoundTrip)
+{
+    std::string path = "trajectory_file_packed_test.bin";
+    std::remove(path.c_str());
+
+    // values each codec is picked for, plus extremes and odd block sizes
+    std::vector<std::vector<TestRow>> chunks;
+    for (int number_of_rows : {1, 2, 31, 33, 1000})
+    {
+        std::vector<TestRow> rows;
+        double time = 0.0;
+        for (int i = 0; i < number_of_rows; i++)
+        {
+            time += 1e-9 * ((i * 7919) % 101 + 1);
+            rows.push_back(TestRow{.seed = number_of_rows,
+                                   .step = 3 * i - 5,
+                                   .reaction_id = static_cast<int>((i * 2654435761u) % 1000),
+                                   .time = time});
+        }
+        chunks.push_back(rows);
+    }
+
+    // mostly a single value, as the second site of lattice reactions
+    std::vector<TestRow> runs;
+    for (int i = 0; i < 500; i++)
+        runs.push_back(TestRow{.seed = 6,
+                               .step = i,
+                               .reaction_id = i % 37 == 0 ? 100000 + i : -2,
+                               .time = 1.0});
+    chunks.push_back(runs);
+
+    std::vector<TestRow> extremes = {
+        {.seed = 7, .step = std::numeric_limits<int>::max(), .reaction_id = -1, .time = -0.0},
+        {.seed = 7, .step = std::numeric_limits<int>::min(), .reaction_id = 0, .time = std::numeric_limits<double>::quiet_NaN()},
+        {.seed = 7, .step = 0, .reaction_id = std::numeric_limits<int>::max(), .time = std::numeric_limits<double>::infinity()},
+        {.seed = 7, .step = -1, .reaction_id = std::numeric_limits<int>::min(), .time = std::numeric_limits<double>::denorm_min()}};
+    chunks.push_back(extremes);
+
+    {
+        TrajectoryFileWriter writer(path, test_columns);
+        for (const std::vector<TestRow> &rows : chunks)
+            writer.append(encode_trajectory_chunk(rows[0].seed, rows, test_columns, chunk_packed));
+    }
+
+    TrajectoryFileReader reader(path);
+    std::vector<int> steps, reaction_ids;
+    std::vector<double> times;
+    for (const std::vector<TestRow> &rows : chunks)
+    {
+        auto [first, last] = reader.chunks_of_seed(rows[0].seed);
+        ASSERT_EQ(last - first, 1u);
+        EXPECT_EQ(reader.encoding(first), chunk_packed);
+        reader.column<int>(first, 0, steps);
+        reader.column<int>(first, 1, reaction_ids);
+        reader.column<double>(first, 2, times);
+
+        ASSERT_EQ(steps.size(), rows.size());
+        for (unsigned long int i = 0; i < rows.size(); i++)
+        {
+            EXPECT_EQ(steps[i], rows[i].step);
+            EXPECT_EQ(reaction_ids[i], rows[i].reaction_id);
+            EXPECT_EQ(std::memcmp(&times[i], &rows[i].time, sizeof(double)), 0);
+        }
+    }
+
+    // the step of a packet is implicit, it costs the same for any
+    // number of rows
+    std::vector<char> packed = encode_trajectory_chunk(1, chunks[4], test_columns, chunk_packed);
+    std::vector<char> raw = encode_trajectory_chunk(1, chunks[4], test_columns);
+    EXPECT_LT(packed.size() * 2, raw.size());
+
+    std::remove(path.c_str());
+}